@@ -0,0 +1,135 @@
+/*
+*   Slab arena used by Graph for its vertices and adjacency maps
+*   Allocations are rounded up to a power of two size class and carved out of 64 KiB slabs (bigger requests
+*   get a slab of their own). Freed blocks go on a per class free list for reuse, and release() hands every
+*   slab back at once, so tearing down a graph costs O(slabs) instead of one free per hash node.
+*   Compile with -DGRAPH_NO_ARENA to route everything through operator new/delete instead (for comparisons).
+*/
+
+#pragma once
+#include <vector>
+#include <new> // operator new
+#include <cstddef> // max_align_t
+
+class Arena {
+    static constexpr size_t slab_size = 64 * 1024;
+    static constexpr size_t min_class = 4; // 16 bytes, enough for the free list link and max_align_t on x86-64
+    static constexpr size_t classes = 64;
+
+    struct Block { Block* next; };
+
+    std::vector<void*> slabs;
+    char* cursor;  // free space left in the current small-object slab
+    size_t left;
+    Block* free_lists[classes];
+    size_t reserved; // bytes held in slabs
+    size_t live;     // bytes handed out and not yet returned
+
+    static size_t size_class(size_t bytes) {
+        size_t c = min_class;
+        while ((static_cast<size_t>(1) << c) < bytes) c++;
+        return c;
+    }
+
+    void* new_slab(size_t bytes) {
+        void* slab = ::operator new(bytes);
+        slabs.push_back(slab);
+        reserved += bytes;
+        return slab;
+    }
+
+    public:
+#ifdef GRAPH_NO_ARENA
+    static constexpr bool pooled = false;
+#else
+    static constexpr bool pooled = true; // release() frees everything, so owners may skip destructors
+#endif
+
+    Arena() : slabs{}, cursor{nullptr}, left{0}, free_lists{}, reserved{0}, live{0} {}
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena() { release(); }
+
+    void* allocate(size_t bytes) {
+        if (!pooled) return ::operator new(bytes);
+
+        size_t c = size_class(bytes);
+        size_t size = static_cast<size_t>(1) << c;
+        live += size;
+
+        if (free_lists[c] != nullptr) {
+            Block* block = free_lists[c];
+            free_lists[c] = block->next;
+            return block;
+        }
+        if (size > slab_size / 4) return new_slab(size); // large blocks (hash bucket arrays) get their own slab
+
+        if (left < size) {
+            cursor = static_cast<char*>(new_slab(slab_size));
+            left = slab_size;
+        }
+        void* block = cursor;
+        cursor += size;
+        left -= size;
+        return block;
+    }
+
+    void deallocate(void* p, size_t bytes) {
+        if (!pooled) { ::operator delete(p); return; }
+
+        size_t c = size_class(bytes);
+        live -= static_cast<size_t>(1) << c;
+        Block* block = static_cast<Block*>(p);
+        block->next = free_lists[c];
+        free_lists[c] = block;
+    }
+
+    // frees every slab - anything still allocated from this arena is gone afterwards
+    void release() {
+        for (void* slab : slabs) {
+            ::operator delete(slab);
+        }
+        slabs.clear();
+        cursor = nullptr;
+        left = 0;
+        for (Block*& list : free_lists) {
+            list = nullptr;
+        }
+        reserved = 0;
+        live = 0;
+    }
+
+    size_t bytes_reserved() const { return reserved; }
+    size_t bytes_in_use() const { return live; }
+    size_t slab_count() const { return slabs.size(); }
+};
+
+// std allocator adaptor - a null arena falls back to operator new/delete
+template <class T>
+class ArenaAllocator {
+    template <class U> friend class ArenaAllocator;
+    Arena* arena;
+
+    public:
+    typedef T value_type;
+
+    ArenaAllocator() : arena{nullptr} {}
+    explicit ArenaAllocator(Arena* arena) : arena{arena} {}
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena{other.arena} {}
+
+    T* allocate(size_t n) {
+        if (arena == nullptr) return static_cast<T*>(::operator new(n * sizeof(T)));
+        return static_cast<T*>(arena->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T* p, size_t n) {
+        if (arena == nullptr) ::operator delete(p);
+        else arena->deallocate(p, n * sizeof(T));
+    }
+
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
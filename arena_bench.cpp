@@ -0,0 +1,47 @@
+#include "graph.h"
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <string>
+#include <sys/resource.h> // getrusage
+
+// graph load / teardown cost and peak RSS - `make arena_bench` runs it with and without the arena
+// usage: ./arena_bench [vertices] [edges]
+
+long peak_rss_kb() {
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss; // kilobytes on Linux
+}
+
+int main(int argc, char** argv) {
+    size_t vertices = argc > 1 ? std::stoul(argv[1]) : 200000;
+    size_t edges = argc > 2 ? std::stoul(argv[2]) : 2000000;
+
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<size_t> vertex(0, vertices - 1);
+    std::uniform_real_distribution<double> weight(1, 100);
+
+    long baseline = peak_rss_kb();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Graph* g = new Graph();
+    for (size_t n = 0; n < vertices; n++) {
+        g->add_vertex(n);
+    }
+    while (g->edge_count() < edges) {
+        g->add_edge(vertex(rng), vertex(rng), weight(rng));
+    }
+    std::chrono::duration<double, std::milli> load = std::chrono::steady_clock::now() - start;
+    long loaded = peak_rss_kb();
+    size_t arena = g->arena_bytes();
+
+    start = std::chrono::steady_clock::now();
+    delete g;
+    std::chrono::duration<double, std::milli> teardown = std::chrono::steady_clock::now() - start;
+
+    std::cout << "mode,vertices,edges,load_ms,teardown_ms,peak_rss_mb,arena_mb" << std::endl;
+    std::cout << (Arena::pooled ? "arena" : "operator_new") << "," << vertices << "," << edges << ","
+              << load.count() << "," << teardown.count() << "," << (loaded - baseline) / 1024.0 << ","
+              << arena / (1024.0 * 1024.0) << std::endl;
+    return 0;
+}
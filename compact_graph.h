@@ -0,0 +1,325 @@
+/*
+*   Immutable compressed-sparse-row (CSR) snapshot of a directed graph
+*   Vertices are renumbered to dense indices 0..V-1 (in ascending order of their original IDs) and
+*   the outgoing edges of vertex u live in targets/weights[offsets[u] .. offsets[u + 1])
+*   The arrays are either owned or viewed read-only in a file written by save() and mapped by open_mapped().
+*   Negative weights are allowed in the arrays (Graph::freeze copies them), but the searches over a snapshot -
+*   dijkstra here, DeltaStepping and ContractionHierarchy - refuse it with domain_error, like Graph's own searches.
+*/
+
+#pragma once
+#include <vector>
+#include <utility> // move, pair
+#include <algorithm> // lower_bound
+#include <cmath> // INFINITY
+#include <queue> // dijkstra
+#include <stack> // print_shortest_path
+#include <iostream> // print_shortest_path
+#include <stdexcept> // invalid_argument, runtime_error, domain_error
+#include <memory> // shared_ptr
+#include <fstream> // save
+#include <string>
+#include <cstdint> // uint32_t, uint64_t
+#include <cstring> // memcpy
+#include "mapped_file.h"
+#include "search_stats.h"
+
+class CompactGraph {
+    static constexpr uint32_t format_version = 1;
+    static constexpr size_t header_size = 32;
+
+    // owned arrays - left empty when the graph views a mapped file instead
+    std::vector<size_t> id_store;
+    std::vector<size_t> offset_store;
+    std::vector<size_t> target_store;
+    std::vector<double> weight_store;
+    std::shared_ptr<const MappedFile> mapping; // shared by copies, unmapped with the last one
+
+    // the CSR arrays, pointing into the stores above or into the mapping
+    const size_t* ids;     // dense index -> original ID (sorted ascending)
+    const size_t* offsets; // dense index -> first edge slot, size V + 1
+    const size_t* targets; // edge slot -> dense index of the edge destination
+    const double* weights; // edge slot -> edge weight
+    size_t vertices;
+    size_t edge_total;
+    size_t negatives; // edges with a negative weight
+
+    // results of the last dijkstra run, indexed by dense index
+    std::vector<double> distances;
+    std::vector<size_t> predecessors;
+
+    public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    // constructors
+    CompactGraph() : CompactGraph(std::vector<size_t>(), std::vector<size_t>{0}, std::vector<size_t>(), std::vector<double>()) {}
+
+    CompactGraph(std::vector<size_t> ids, std::vector<size_t> offsets, std::vector<size_t> targets, std::vector<double> weights)
+        : id_store{std::move(ids)}, offset_store{std::move(offsets)}, target_store{std::move(targets)}, weight_store{std::move(weights)},
+          mapping{}, ids{nullptr}, offsets{nullptr}, targets{nullptr}, weights{nullptr}, vertices{0}, edge_total{0}, negatives{0},
+          distances{}, predecessors{} {
+        /*
+         *  ids must be sorted ascending, offsets must hold vertex_count() + 1 non-decreasing entries ending at the
+         *  edge count and every row of targets must be sorted ascending (contains_edge binary searches a row)
+        */
+        if (offset_store.size() != id_store.size() + 1 || offset_store.front() != 0 ||
+            offset_store.back() != target_store.size() || target_store.size() != weight_store.size()) {
+            throw std::invalid_argument("CompactGraph: inconsistent CSR arrays");
+        }
+        view_stores();
+    }
+
+    // copies of a mapped graph share the mapping, copies of an owning graph get their own arrays
+    CompactGraph(const CompactGraph& other)
+        : id_store{other.id_store}, offset_store{other.offset_store}, target_store{other.target_store}, weight_store{other.weight_store},
+          mapping{other.mapping}, ids{other.ids}, offsets{other.offsets}, targets{other.targets}, weights{other.weights},
+          vertices{other.vertices}, edge_total{other.edge_total}, negatives{other.negatives}, distances{other.distances},
+          predecessors{other.predecessors} {
+        if (!mapping) view_stores();
+    }
+
+    CompactGraph& operator=(const CompactGraph& other) {
+        if (this == &other) return *this;
+        CompactGraph copy(other);
+        *this = std::move(copy);
+        return *this;
+    }
+
+    // moving a vector keeps its buffer, so the views stay valid
+    CompactGraph(CompactGraph&&) = default;
+    CompactGraph& operator=(CompactGraph&&) = default;
+
+    // capacity
+    size_t vertex_count() const { return vertices; }
+    size_t edge_count() const { return edge_total; }
+    bool mapped() const { return mapping != nullptr; }
+    bool has_negative_weights() const { return negatives > 0; }
+
+    // the check every search over a snapshot starts with - same message as Graph's searches
+    void require_non_negative() const {
+        if (negatives > 0) throw std::domain_error("negative edge weights need bellman_ford or Johnson reweighting");
+    }
+
+    // id mapping
+    size_t index_of(size_t id) const {
+        const size_t* it = std::lower_bound(ids, ids + vertices, id);
+        if (it == ids + vertices || *it != id) return npos;
+        return static_cast<size_t>(it - ids);
+    }
+
+    size_t id_of(size_t index) const {
+        if (index >= vertices) throw std::out_of_range("CompactGraph::id_of");
+        return ids[index];
+    }
+
+    // raw CSR access (by dense index)
+    size_t degree(size_t index) const { return offsets[index + 1] - offsets[index]; }
+    size_t edges_begin(size_t index) const { return offsets[index]; }
+    size_t edges_end(size_t index) const { return offsets[index + 1]; }
+    size_t target(size_t edge) const { return targets[edge]; }
+    double weight(size_t edge) const { return weights[edge]; }
+
+    // element access (by original ID)
+    bool contains_vertex(size_t id) const { return index_of(id) != npos; }
+
+    bool contains_edge(size_t src, size_t dest) const {
+        return edge_slot(src, dest) != npos;
+    }
+
+    double cost(size_t src, size_t dest) const {
+        size_t edge = edge_slot(src, dest);
+        if (edge == npos) return INFINITY; // same convention as Graph::cost
+        return weights[edge];
+    }
+
+    // dijkstra methods
+    void dijkstra(size_t src) {
+        require_non_negative();
+        SearchRecorder recorder("compact_dijkstra", src);
+        distances.assign(vertex_count(), INFINITY);
+        predecessors.assign(vertex_count(), npos);
+
+        size_t source = index_of(src);
+        if (source == npos) return; // confirm source vertex exists
+
+        std::vector<bool> visited(vertex_count(), false);
+        std::priority_queue<std::pair<double, size_t>, std::vector<std::pair<double, size_t>>, std::greater<std::pair<double, size_t>>> q;
+        distances[source] = 0;
+        q.push(std::pair<double, size_t>(0, source));
+        recorder.push(q.size());
+        recorder.phase("setup");
+
+        while (!q.empty()) {
+            size_t current = q.top().second;
+            q.pop();
+
+            if (visited[current]) { // shortest path is known
+                recorder.stale();
+                continue;
+            }
+            visited[current] = true;
+            recorder.settle();
+
+            // relax every outgoing edge - the row is contiguous so this is a linear scan
+            double base = distances[current];
+            recorder.relax(offsets[current + 1] - offsets[current]);
+            for (size_t edge = offsets[current]; edge < offsets[current + 1]; edge++) {
+                size_t next = targets[edge];
+                double candidate = base + weights[edge];
+                if (candidate < distances[next]) {
+                    distances[next] = candidate;
+                    predecessors[next] = current;
+                    q.push(std::pair<double, size_t>(candidate, next));
+                    recorder.push(q.size());
+                }
+            }
+        }
+        recorder.phase("search");
+    }
+
+    // helper for dijkstra
+    double distance(size_t id) const {
+        size_t index = index_of(id);
+        if (index == npos || index >= distances.size()) return INFINITY;
+        return distances[index];
+    }
+
+    // visual representation
+    void print_shortest_path(size_t id, std::ostream& os = std::cout) const {
+        // same contract and output format as Graph::print_shortest_path
+        size_t index = index_of(id);
+        if (index == npos || index >= distances.size() || distances[index] == INFINITY) {
+            os << "<no path>" << std::endl;
+            return;
+        }
+
+        std::stack<size_t> s; // to store path
+        for (size_t tmpPred = index; tmpPred != npos; tmpPred = predecessors[tmpPred]) {
+            s.push(ids[tmpPred]);
+        }
+
+        size_t currID;
+        while (!s.empty()) {
+            currID = s.top();
+            currID == id ? os << currID : os << currID << " --> ";
+            s.pop();
+        }
+
+        os << " distance: " << distance(id) << std::endl;
+    }
+
+    // serialization
+    void save(std::ostream& os) const {
+        /*
+         *  file layout, native byte order:
+         *    "GDCG", uint32 version, uint32 sizeof(size_t), uint32 byte order mark, uint64 V, uint64 E
+         *    ids[V], offsets[V + 1], targets[E] as size_t, padding to 8 bytes, weights[E] as double
+         *  the arrays are stored exactly as CompactGraph holds them, so open_mapped can use them in place
+        */
+        os.write("GDCG", 4);
+        write_value(os, format_version);
+        write_value(os, static_cast<uint32_t>(sizeof(size_t)));
+        write_value(os, byte_order_mark);
+        write_value(os, static_cast<uint64_t>(vertices));
+        write_value(os, static_cast<uint64_t>(edge_total));
+        write_array(os, ids, vertices);
+        write_array(os, offsets, vertices + 1);
+        write_array(os, targets, edge_total);
+        size_t padding = weights_position(vertices, edge_total) - header_size - (2 * vertices + 1 + edge_total) * sizeof(size_t);
+        os.write("\0\0\0\0\0\0\0", static_cast<std::streamsize>(padding));
+        write_array(os, weights, edge_total);
+        if (!os) throw std::runtime_error("CompactGraph: write failed");
+    }
+
+    void save(const std::string& path) const {
+        std::ofstream os(path, std::ios::binary);
+        if (!os) throw std::runtime_error("CompactGraph: cannot open " + path);
+        save(os);
+    }
+
+    static CompactGraph open_mapped(const std::string& path) {
+        /*
+         *  maps a file written by save() and views its arrays in place - nothing is parsed or copied, so this is
+         *  O(1) in parsing and queries fault pages in as they touch them. Only the header and the ends of offsets are
+         *  checked; the weights are read once to count the negative ones, the one scan done on open
+        */
+        std::shared_ptr<const MappedFile> file = std::make_shared<const MappedFile>(path);
+        const char* base = file->data();
+        if (file->size() < header_size || std::string(base, 4) != "GDCG") throw std::runtime_error("CompactGraph: not a graph file");
+
+        uint32_t version, word, mark;
+        uint64_t vertex_count, edge_count;
+        std::memcpy(&version, base + 4, sizeof version);
+        std::memcpy(&word, base + 8, sizeof word);
+        std::memcpy(&mark, base + 12, sizeof mark);
+        std::memcpy(&vertex_count, base + 16, sizeof vertex_count);
+        std::memcpy(&edge_count, base + 24, sizeof edge_count);
+        if (version != format_version) throw std::runtime_error("CompactGraph: unsupported version");
+        if (word != sizeof(size_t) || mark != byte_order_mark) throw std::runtime_error("CompactGraph: file written on an incompatible platform");
+
+        size_t end = weights_position(vertex_count, edge_count) + edge_count * sizeof(double);
+        if (vertex_count > file->size() || edge_count > file->size() || file->size() != end) throw std::runtime_error("CompactGraph: corrupt file");
+
+        CompactGraph g;
+        g.mapping = file;
+        g.ids = reinterpret_cast<const size_t*>(base + header_size);
+        g.offsets = g.ids + vertex_count;
+        g.targets = g.offsets + vertex_count + 1;
+        g.weights = reinterpret_cast<const double*>(base + weights_position(vertex_count, edge_count));
+        g.vertices = vertex_count;
+        g.edge_total = edge_count;
+        g.id_store.clear();
+        g.offset_store.clear();
+        if (g.offsets[0] != 0 || g.offsets[vertex_count] != edge_count) throw std::runtime_error("CompactGraph: corrupt file");
+        g.count_negatives();
+        return g;
+    }
+
+    private:
+    static constexpr uint32_t byte_order_mark = 0x01020304;
+
+    size_t edge_slot(size_t src, size_t dest) const {
+        size_t source = index_of(src);
+        size_t destination = index_of(dest);
+        if (source == npos || destination == npos) return npos;
+
+        const size_t* first = targets + offsets[source];
+        const size_t* last = targets + offsets[source + 1];
+        const size_t* it = std::lower_bound(first, last, destination);
+        if (it == last || *it != destination) return npos;
+        return static_cast<size_t>(it - targets);
+    }
+
+    void view_stores() {
+        ids = id_store.data();
+        offsets = offset_store.data();
+        targets = target_store.data();
+        weights = weight_store.data();
+        vertices = id_store.size();
+        edge_total = target_store.size();
+        count_negatives();
+    }
+
+    void count_negatives() {
+        negatives = 0;
+        for (size_t edge = 0; edge < edge_total; edge++) {
+            if (weights[edge] < 0) negatives++;
+        }
+    }
+
+    // layout of the arrays after the header - weights start on an 8 byte boundary whatever the word size
+    static size_t weights_position(size_t vertex_count, size_t edge_count) {
+        size_t end = header_size + (2 * vertex_count + 1 + edge_count) * sizeof(size_t);
+        return (end + 7) / 8 * 8;
+    }
+
+    template <class T>
+    static void write_value(std::ostream& os, T value) {
+        os.write(reinterpret_cast<const char*>(&value), sizeof value);
+    }
+
+    template <class T>
+    static void write_array(std::ostream& os, const T* data, size_t count) {
+        os.write(reinterpret_cast<const char*>(data), static_cast<std::streamsize>(count * sizeof(T)));
+    }
+};
@@ -0,0 +1,49 @@
+#include "graph.h"
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <string>
+
+// incremental add_vertex/add_edge against reserve() and Graph::from_edges - `make construction_bench`
+// usage: ./construction_bench [vertices] [edges]
+
+int main(int argc, char** argv) {
+    size_t vertices = argc > 1 ? std::stoul(argv[1]) : 200000;
+    size_t edge_count = argc > 2 ? std::stoul(argv[2]) : 2000000;
+
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<size_t> vertex(0, vertices - 1);
+    std::uniform_real_distribution<double> weight(1, 100);
+    std::vector<Graph::Edge> edges(edge_count);
+    for (Graph::Edge& edge : edges) {
+        edge = Graph::Edge{vertex(rng), vertex(rng), weight(rng)};
+    }
+    std::vector<size_t> ids(vertices);
+    for (size_t n = 0; n < vertices; n++) {
+        ids[n] = n;
+    }
+
+    std::cout << "method,vertices,edges,ms,edges_kept" << std::endl;
+    for (int method = 0; method < 3; method++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        size_t kept;
+        if (method < 2) {
+            Graph g;
+            if (method == 1) g.reserve(vertices, edge_count);
+            for (size_t id : ids) {
+                g.add_vertex(id);
+            }
+            for (const Graph::Edge& edge : edges) {
+                g.add_edge(edge.src, edge.dest, edge.weight);
+            }
+            kept = g.edge_count();
+        } else {
+            Graph g = Graph::from_edges(edges, ids);
+            kept = g.edge_count();
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        const char* names[] = {"incremental", "incremental_reserved", "from_edges"};
+        std::cout << names[method] << "," << vertices << "," << edge_count << "," << elapsed.count() << "," << kept << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,552 @@
+/*
+*   Contraction hierarchy over a frozen graph for fast point-to-point queries on static graphs
+*   Preprocessing contracts vertices one at a time (cheapest first by edge difference), adding a shortcut
+*   u -> w whenever the only shortest u -> w path ran through the contracted vertex. A query is then a
+*   bidirectional dijkstra that only ever climbs towards more important vertices, settling a tiny search space.
+*/
+
+#pragma once
+#include "graph.h"
+#include "parallel.h"
+#include <vector>
+#include <queue> // contraction order
+#include <fstream> // save, load
+#include <stdexcept> // runtime_error
+#include <cstdint> // uint32_t, uint64_t
+
+class ContractionHierarchy {
+    static constexpr size_t npos = static_cast<size_t>(-1);
+    static constexpr uint32_t format_version = 1;
+
+    // upward (or reversed downward) edges of every vertex in CSR form
+    struct SearchGraph {
+        std::vector<size_t> offsets;
+        std::vector<size_t> targets;
+        std::vector<double> weights;
+        std::vector<size_t> middles; // contracted vertex a shortcut skips, npos for an original edge
+
+        SearchGraph() : offsets{0}, targets{}, weights{}, middles{} {}
+    };
+
+    std::vector<size_t> ids;  // dense index -> original ID, same numbering as the CompactGraph it came from
+    std::vector<size_t> rank; // dense index -> contraction order, higher means more important
+    SearchGraph up;   // u -> w with rank[w] > rank[u], searched forward from the source
+    SearchGraph down; // stored at w: u -> w with rank[u] > rank[w], searched backward from the target
+    size_t shortcuts;
+
+    public:
+    ContractionHierarchy() : ids{}, rank{}, up{}, down{}, shortcuts{0} {}
+    explicit ContractionHierarchy(const Graph& g) : ContractionHierarchy(g.freeze()) {}
+
+    explicit ContractionHierarchy(const CompactGraph& g, size_t witness_settle_limit = 500) : ContractionHierarchy() {
+        /*
+         *  witness_settle_limit caps every witness search - a search that gives up adds a shortcut which
+         *  might not be needed, so smaller limits trade query speed for preprocessing speed, never correctness
+        */
+        g.require_non_negative();
+        Contractor contractor(g, witness_settle_limit);
+        contractor.run(*this);
+        ids.resize(g.vertex_count());
+        for (size_t i = 0; i < ids.size(); i++) {
+            ids[i] = g.id_of(i);
+        }
+    }
+
+    // capacity
+    size_t vertex_count() const { return ids.size(); }
+    size_t shortcut_count() const { return shortcuts; }
+    size_t edge_count() const { return up.targets.size() + down.targets.size(); } // original edges plus shortcuts
+
+    size_t index_of(size_t id) const {
+        std::vector<size_t>::const_iterator it = std::lower_bound(ids.begin(), ids.end(), id);
+        if (it == ids.end() || *it != id) return npos;
+        return static_cast<size_t>(it - ids.begin());
+    }
+
+    bool contains_vertex(size_t id) const { return index_of(id) != npos; }
+
+    // queries - const and thread safe, per-thread buffers are reused between calls
+    double distance(size_t src, size_t dest) const {
+        size_t meet = search(src, dest);
+        if (meet == npos) return INFINITY;
+        Query& q = query_buffers();
+        return q.forward[meet] + q.backward[meet];
+    }
+
+    Graph::Path shortest_path(size_t src, size_t dest) const {
+        Graph::Path best;
+        size_t meet = search(src, dest);
+        if (meet == npos) return best;
+
+        Query& q = query_buffers();
+        best.distance = q.forward[meet] + q.backward[meet];
+
+        // walk the upward half back to the source, then the downward half on to the target, unpacking shortcuts
+        std::vector<size_t> climb;
+        for (size_t v = meet; q.forward_edge[v] != npos; v = q.forward_from[v]) {
+            climb.push_back(q.forward_edge[v]);
+        }
+        best.vertices.push_back(src);
+        for (std::vector<size_t>::reverse_iterator it = climb.rbegin(); it != climb.rend(); it++) {
+            size_t edge = *it;
+            size_t from = q.forward_from[up.targets[edge]];
+            unpack(from, up.targets[edge], up.middles[edge], best.vertices);
+        }
+        for (size_t v = meet; q.backward_edge[v] != npos; v = q.backward_from[v]) {
+            unpack(v, q.backward_from[v], down.middles[q.backward_edge[v]], best.vertices);
+        }
+        return best;
+    }
+
+    void distance_matrix(const std::vector<size_t>& sources, const std::vector<size_t>& targets, double* out, size_t threads = 0) const {
+        /*
+         *  many-to-many with buckets: one backward upward search per target leaves (column, distance) at every
+         *  vertex it reaches, then one forward upward search per source (in parallel) scans the buckets of the
+         *  vertices it reaches. Same output layout as Graph::distance_matrix
+        */
+        std::fill(out, out + sources.size() * targets.size(), INFINITY);
+        if (targets.empty()) return;
+
+        std::vector<std::vector<std::pair<size_t, double>>> buckets(ids.size());
+        for (size_t j = 0; j < targets.size(); j++) {
+            size_t target = index_of(targets[j]);
+            if (target == npos) continue;
+            upward(target, down, [&buckets, j](size_t v, double d) { buckets[v].push_back(std::pair<size_t, double>(j, d)); });
+        }
+
+        parallel_for(sources.size(), threads, [this, &sources, &targets, &buckets, out](size_t i) {
+            size_t source = index_of(sources[i]);
+            if (source == npos) return;
+            double* row = out + i * targets.size();
+            upward(source, up, [&buckets, row](size_t v, double d) {
+                for (const std::pair<size_t, double>& entry : buckets[v]) {
+                    row[entry.first] = std::min(row[entry.first], d + entry.second);
+                }
+            });
+        });
+    }
+
+    // serialization - native byte order, meant for restarting a service on the same machine type
+    void save(std::ostream& os) const {
+        os.write("GDCH", 4);
+        write_value(os, format_version);
+        write_value(os, static_cast<uint64_t>(shortcuts));
+        write_vector(os, ids);
+        write_vector(os, rank);
+        for (const SearchGraph* side : {&up, &down}) {
+            write_vector(os, side->offsets);
+            write_vector(os, side->targets);
+            write_vector(os, side->weights);
+            write_vector(os, side->middles);
+        }
+        if (!os) throw std::runtime_error("ContractionHierarchy: write failed");
+    }
+
+    void save(const std::string& path) const {
+        std::ofstream os(path, std::ios::binary);
+        if (!os) throw std::runtime_error("ContractionHierarchy: cannot open " + path);
+        save(os);
+    }
+
+    static ContractionHierarchy load(std::istream& is) {
+        char magic[4] = {};
+        is.read(magic, 4);
+        if (!is || std::string(magic, 4) != "GDCH") throw std::runtime_error("ContractionHierarchy: not a hierarchy file");
+        if (read_value<uint32_t>(is) != format_version) throw std::runtime_error("ContractionHierarchy: unsupported version");
+
+        ContractionHierarchy ch;
+        ch.shortcuts = static_cast<size_t>(read_value<uint64_t>(is));
+        read_vector(is, ch.ids);
+        read_vector(is, ch.rank);
+        for (SearchGraph* side : {&ch.up, &ch.down}) {
+            read_vector(is, side->offsets);
+            read_vector(is, side->targets);
+            read_vector(is, side->weights);
+            read_vector(is, side->middles);
+            if (side->offsets.size() != ch.ids.size() + 1 || side->offsets.back() != side->targets.size() ||
+                side->weights.size() != side->targets.size() || side->middles.size() != side->targets.size()) {
+                throw std::runtime_error("ContractionHierarchy: corrupt file");
+            }
+        }
+        if (ch.rank.size() != ch.ids.size()) throw std::runtime_error("ContractionHierarchy: corrupt file");
+        return ch;
+    }
+
+    static ContractionHierarchy load(const std::string& path) {
+        std::ifstream is(path, std::ios::binary);
+        if (!is) throw std::runtime_error("ContractionHierarchy: cannot open " + path);
+        return load(is);
+    }
+
+    private:
+    // per-thread query state, entries are valid when their stamp matches epoch
+    struct Query {
+        std::vector<double> forward, backward;
+        std::vector<size_t> forward_from, backward_from; // previous vertex on each half
+        std::vector<size_t> forward_edge, backward_edge; // edge slot in up / down used to get here, npos at the ends
+        std::vector<size_t> forward_stamp, backward_stamp;
+        size_t epoch;
+        BinaryHeap forward_queue, backward_queue;
+
+        Query() : forward{}, backward{}, forward_from{}, backward_from{}, forward_edge{}, backward_edge{},
+                  forward_stamp{}, backward_stamp{}, epoch{0}, forward_queue{}, backward_queue{} {}
+
+        // size the arrays for an n vertex hierarchy and start a new query
+        void prepare(size_t n) {
+            if (forward_stamp.size() < n) {
+                for (std::vector<double>* d : {&forward, &backward}) d->resize(n);
+                for (std::vector<size_t>* v : {&forward_from, &backward_from, &forward_edge, &backward_edge}) v->resize(n);
+                forward_stamp.resize(n, 0);
+                backward_stamp.resize(n, 0);
+            }
+            epoch++;
+        }
+    };
+
+    static Query& query_buffers() {
+        static thread_local Query q;
+        return q;
+    }
+
+    // returns the vertex where the best up-down route meets, npos when there is no route
+    size_t search(size_t src, size_t dest) const {
+        SearchRecorder recorder("ch_query", src);
+        size_t source = index_of(src);
+        size_t target = index_of(dest);
+        if (source == npos || target == npos) return npos;
+
+        Query& q = query_buffers();
+        q.prepare(ids.size());
+        q.forward_queue.clear(ids.size());
+        q.backward_queue.clear(ids.size());
+
+        q.forward[source] = 0;
+        q.forward_from[source] = npos;
+        q.forward_edge[source] = npos;
+        q.forward_stamp[source] = q.epoch;
+        q.forward_queue.push(source, 0);
+        recorder.push(q.forward_queue.size());
+        q.backward[target] = 0;
+        q.backward_from[target] = npos;
+        q.backward_edge[target] = npos;
+        q.backward_stamp[target] = q.epoch;
+        q.backward_queue.push(target, 0);
+        recorder.push(q.forward_queue.size() + q.backward_queue.size());
+        recorder.phase("setup");
+
+        double mu = INFINITY;
+        size_t meet = npos;
+        bool forward_turn = true;
+        while (!q.forward_queue.empty() || !q.backward_queue.empty()) {
+            bool is_forward = forward_turn ? !q.forward_queue.empty() : q.backward_queue.empty();
+            forward_turn = !forward_turn;
+
+            const SearchGraph& side = is_forward ? up : down;
+            BinaryHeap& queue = is_forward ? q.forward_queue : q.backward_queue;
+            std::vector<double>& dist = is_forward ? q.forward : q.backward;
+            std::vector<size_t>& from = is_forward ? q.forward_from : q.backward_from;
+            std::vector<size_t>& via = is_forward ? q.forward_edge : q.backward_edge;
+            std::vector<size_t>& stamp = is_forward ? q.forward_stamp : q.backward_stamp;
+            const std::vector<double>& other = is_forward ? q.backward : q.forward;
+            const std::vector<size_t>& other_stamp = is_forward ? q.backward_stamp : q.forward_stamp;
+
+            std::pair<double, size_t> current = queue.pop();
+            size_t u = current.second;
+            if (current.first > dist[u]) { // stale entry
+                recorder.stale();
+                continue;
+            }
+            if (current.first >= mu) {
+                queue.clear(ids.size()); // this side cannot improve the route any more
+                continue;
+            }
+            recorder.settle();
+            recorder.relax(side.offsets[u + 1] - side.offsets[u]);
+
+            if (other_stamp[u] == q.epoch && current.first + other[u] < mu) {
+                mu = current.first + other[u];
+                meet = u;
+            }
+
+            for (size_t edge = side.offsets[u]; edge < side.offsets[u + 1]; edge++) {
+                size_t next = side.targets[edge];
+                double candidate = current.first + side.weights[edge];
+                if (stamp[next] != q.epoch || candidate < dist[next]) {
+                    dist[next] = candidate;
+                    from[next] = u;
+                    via[next] = edge;
+                    stamp[next] = q.epoch;
+                    queue.push(next, candidate);
+                    recorder.push(q.forward_queue.size() + q.backward_queue.size());
+                }
+            }
+        }
+        recorder.phase("search");
+        return meet;
+    }
+
+    // complete dijkstra over one search graph from source, calling visit(vertex, distance) as each vertex settles
+    template <class Visit>
+    void upward(size_t source, const SearchGraph& side, Visit visit) const {
+        Query& q = query_buffers();
+        q.prepare(ids.size());
+        q.forward_queue.clear(ids.size());
+
+        q.forward[source] = 0;
+        q.forward_stamp[source] = q.epoch;
+        q.forward_queue.push(source, 0);
+        while (!q.forward_queue.empty()) {
+            std::pair<double, size_t> current = q.forward_queue.pop();
+            if (current.first > q.forward[current.second]) continue; // stale entry
+            visit(current.second, current.first);
+
+            for (size_t edge = side.offsets[current.second]; edge < side.offsets[current.second + 1]; edge++) {
+                size_t next = side.targets[edge];
+                double candidate = current.first + side.weights[edge];
+                if (q.forward_stamp[next] != q.epoch || candidate < q.forward[next]) {
+                    q.forward[next] = candidate;
+                    q.forward_stamp[next] = q.epoch;
+                    q.forward_queue.push(next, candidate);
+                }
+            }
+        }
+    }
+
+    // edge slot of a -> b in a search graph row, both directions store the lower ranked end as the row
+    static size_t find_edge(const SearchGraph& side, size_t row, size_t other) {
+        for (size_t edge = side.offsets[row]; edge < side.offsets[row + 1]; edge++) {
+            if (side.targets[edge] == other) return edge;
+        }
+        return npos;
+    }
+
+    // appends the original vertices of edge a -> b after a (b included, a not)
+    void unpack(size_t a, size_t b, size_t middle, std::vector<size_t>& out) const {
+        std::vector<std::pair<std::pair<size_t, size_t>, size_t>> pending; // (a, b), middle - last on top
+        pending.push_back(std::make_pair(std::make_pair(a, b), middle));
+        while (!pending.empty()) {
+            std::pair<std::pair<size_t, size_t>, size_t> edge = pending.back();
+            pending.pop_back();
+            if (edge.second == npos) {
+                out.push_back(ids[edge.first.second]);
+                continue;
+            }
+
+            // the middle vertex was contracted before both ends: a -> m lives in down[m], m -> b in up[m]
+            size_t m = edge.second;
+            size_t first = find_edge(down, m, edge.first.first);
+            size_t second = find_edge(up, m, edge.first.second);
+            pending.push_back(std::make_pair(std::make_pair(m, edge.first.second), up.middles[second]));
+            pending.push_back(std::make_pair(std::make_pair(edge.first.first, m), down.middles[first]));
+        }
+    }
+
+    // binary i/o helpers
+    template <class T>
+    static void write_value(std::ostream& os, T value) {
+        os.write(reinterpret_cast<const char*>(&value), sizeof value);
+    }
+
+    template <class T>
+    static T read_value(std::istream& is) {
+        T value{};
+        is.read(reinterpret_cast<char*>(&value), sizeof value);
+        if (!is) throw std::runtime_error("ContractionHierarchy: truncated file");
+        return value;
+    }
+
+    template <class T>
+    static void write_vector(std::ostream& os, const std::vector<T>& v) {
+        write_value(os, static_cast<uint64_t>(v.size()));
+        os.write(reinterpret_cast<const char*>(v.data()), static_cast<std::streamsize>(v.size() * sizeof(T)));
+    }
+
+    template <class T>
+    static void read_vector(std::istream& is, std::vector<T>& v) {
+        uint64_t size = read_value<uint64_t>(is);
+        v.resize(static_cast<size_t>(size));
+        is.read(reinterpret_cast<char*>(v.data()), static_cast<std::streamsize>(v.size() * sizeof(T)));
+        if (!is) throw std::runtime_error("ContractionHierarchy: truncated file");
+    }
+
+    // preprocessing state, only alive while the hierarchy is being built
+    class Contractor {
+        struct Arc {
+            size_t node;
+            double weight;
+            size_t middle;
+        };
+
+        size_t n;
+        size_t settle_limit;
+        std::vector<std::vector<Arc>> out, in; // remaining graph, contracted vertices are unlinked
+        std::vector<bool> contracted;
+        std::vector<size_t> deleted_neighbors;
+
+        // witness search buffers
+        std::vector<double> dist;
+        std::vector<size_t> stamp;
+        size_t epoch;
+        BinaryHeap queue;
+
+        public:
+        Contractor(const CompactGraph& g, size_t settle_limit)
+            : n{g.vertex_count()}, settle_limit{settle_limit}, out(g.vertex_count()), in(g.vertex_count()),
+              contracted(g.vertex_count(), false), deleted_neighbors(g.vertex_count(), 0),
+              dist(g.vertex_count(), INFINITY), stamp(g.vertex_count(), 0), epoch{0}, queue{} {
+            for (size_t u = 0; u < n; u++) {
+                for (size_t edge = g.edges_begin(u); edge < g.edges_end(u); edge++) {
+                    size_t w = g.target(edge);
+                    if (w == u) continue; // self loops never lie on a shortest path
+                    out[u].push_back(Arc{w, g.weight(edge), npos});
+                    in[w].push_back(Arc{u, g.weight(edge), npos});
+                }
+            }
+        }
+
+        void run(ContractionHierarchy& ch) {
+            ch.rank.assign(n, 0);
+            std::vector<std::vector<Arc>> ups(n), downs(n);
+
+            // lazy updates: a popped vertex is contracted only if its refreshed priority is still the smallest
+            typedef std::pair<long, size_t> Entry;
+            std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> order;
+            for (size_t v = 0; v < n; v++) {
+                order.push(Entry(priority(v), v));
+            }
+
+            size_t next_rank = 0;
+            while (!order.empty()) {
+                size_t v = order.top().second;
+                order.pop();
+                long refreshed = priority(v);
+                if (!order.empty() && refreshed > order.top().first) {
+                    order.push(Entry(refreshed, v));
+                    continue;
+                }
+
+                ch.rank[v] = next_rank++;
+                ups[v] = out[v];
+                downs[v] = in[v];
+                ch.shortcuts += contract(v, false);
+            }
+
+            build(ups, ch.up);
+            build(downs, ch.down);
+        }
+
+        private:
+        long priority(size_t v) {
+            // edge difference plus a uniformity term so contraction spreads over the graph
+            long added = static_cast<long>(contract(v, true));
+            long removed = static_cast<long>(out[v].size() + in[v].size());
+            return added - removed + static_cast<long>(deleted_neighbors[v]);
+        }
+
+        // contracts v (or only counts the shortcuts it would need when simulating)
+        size_t contract(size_t v, bool simulate) {
+            size_t added = 0;
+            for (const Arc& incoming : in[v]) {
+                size_t u = incoming.node;
+
+                double limit = 0;
+                for (const Arc& outgoing : out[v]) {
+                    if (outgoing.node != u) limit = std::max(limit, incoming.weight + outgoing.weight);
+                }
+                witness_search(u, v, limit);
+
+                for (const Arc& outgoing : out[v]) {
+                    size_t w = outgoing.node;
+                    if (w == u) continue;
+                    double via = incoming.weight + outgoing.weight;
+                    if (stamp[w] == epoch && dist[w] <= via) continue; // a witness path avoids v
+
+                    if (simulate) added++;
+                    else if (add_shortcut(u, w, via, v)) added++;
+                }
+            }
+
+            if (!simulate) {
+                // unlink v from the remaining graph
+                for (const Arc& incoming : in[v]) {
+                    unlink(out[incoming.node], v);
+                    deleted_neighbors[incoming.node]++;
+                }
+                for (const Arc& outgoing : out[v]) {
+                    unlink(in[outgoing.node], v);
+                    deleted_neighbors[outgoing.node]++;
+                }
+                contracted[v] = true;
+                out[v].clear();
+                in[v].clear();
+            }
+            return added;
+        }
+
+        void witness_search(size_t source, size_t skip, double limit) {
+            epoch++;
+            queue.clear(n);
+            dist[source] = 0;
+            stamp[source] = epoch;
+            queue.push(source, 0);
+
+            size_t settled = 0;
+            while (!queue.empty() && settled < settle_limit) {
+                std::pair<double, size_t> current = queue.pop();
+                if (current.first > dist[current.second]) continue;
+                if (current.first > limit) break;
+                settled++;
+
+                for (const Arc& arc : out[current.second]) {
+                    if (arc.node == skip) continue;
+                    double candidate = current.first + arc.weight;
+                    if (stamp[arc.node] != epoch || candidate < dist[arc.node]) {
+                        dist[arc.node] = candidate;
+                        stamp[arc.node] = epoch;
+                        queue.push(arc.node, candidate);
+                    }
+                }
+            }
+        }
+
+        bool add_shortcut(size_t u, size_t w, double weight, size_t middle) {
+            // keep one arc per pair - replace a heavier existing one, returns whether a new arc was added
+            for (Arc& arc : out[u]) {
+                if (arc.node != w) continue;
+                if (weight < arc.weight) {
+                    arc.weight = weight;
+                    arc.middle = middle;
+                    for (Arc& back : in[w]) {
+                        if (back.node == u) { back.weight = weight; back.middle = middle; }
+                    }
+                }
+                return false;
+            }
+            out[u].push_back(Arc{w, weight, middle});
+            in[w].push_back(Arc{u, weight, middle});
+            return true;
+        }
+
+        static void unlink(std::vector<Arc>& arcs, size_t node) {
+            for (size_t i = 0; i < arcs.size(); i++) {
+                if (arcs[i].node == node) {
+                    arcs[i] = arcs.back();
+                    arcs.pop_back();
+                    return;
+                }
+            }
+        }
+
+        static void build(const std::vector<std::vector<Arc>>& rows, SearchGraph& side) {
+            side.offsets.assign(1, 0);
+            for (const std::vector<Arc>& row : rows) {
+                for (const Arc& arc : row) {
+                    side.targets.push_back(arc.node);
+                    side.weights.push_back(arc.weight);
+                    side.middles.push_back(arc.middle);
+                }
+                side.offsets.push_back(side.targets.size());
+            }
+        }
+    };
+};
@@ -0,0 +1,209 @@
+/*
+*   Parallel single source shortest paths (delta-stepping, Meyer & Sanders) over a CompactGraph
+*   Tentative distances are grouped into buckets of width delta. All vertices of the lowest bucket are relaxed
+*   together - light edges (weight <= delta) repeatedly until the bucket stops refilling, then heavy edges once -
+*   and each relaxation round is split across a pool of threads kept for the solver's lifetime, since the rounds are
+*   many and short. Weights must be non-negative - a graph with negative ones is refused with domain_error.
+*   Live distances never span more than max weight / delta buckets past the current one, so the buckets are a ring of
+*   that many reused modulo its size; a delta that would need more than max_buckets of them is rejected.
+*/
+
+#pragma once
+#include "compact_graph.h"
+#include "search_stats.h"
+#include "parallel.h"
+#include <vector>
+#include <atomic>
+#include <cstdint> // uint64_t
+#include <cstring> // memcpy
+#include <cmath> // ceil
+#include <stdexcept> // invalid_argument
+
+class DeltaStepping {
+    static constexpr size_t npos = static_cast<size_t>(-1);
+    static constexpr size_t parallel_threshold = 256; // smaller frontiers are relaxed on the calling thread
+    static constexpr size_t max_buckets = size_t(1) << 20;  // ring size limit, 24 MiB of empty buckets
+
+    const CompactGraph& g;
+    double delta;
+    size_t threads;
+
+    // distances as the bit patterns of non-negative doubles, which order like the doubles themselves,
+    // so an atomic compare-exchange loop on the integer is an atomic min on the distance
+    std::vector<std::atomic<uint64_t>> bits;
+    std::vector<std::vector<size_t>> buckets; // ring, bucket i lives at i % buckets.size()
+    size_t queued;                            // entries in all buckets, stale ones included
+    std::vector<size_t> stamp; // last round a vertex was put in the frontier, dedupes bucket entries
+    size_t round;
+    WorkerPool pool;
+
+    public:
+    DeltaStepping(const CompactGraph& g, double delta = 0, size_t threads = 0)
+        : g{g}, delta{delta}, threads{resolve_threads(threads)}, bits(g.vertex_count()), buckets{}, queued{0}, stamp(g.vertex_count(), 0),
+          round{0},
+          pool{this->threads} {
+        /*
+         *  delta <= 0 picks the average edge weight, a reasonable default for road and grid graphs
+         *  threads == 0 uses every hardware thread
+        */
+        g.require_non_negative(); // the bit pattern trick below only orders non-negative doubles
+        double total = 0, heaviest = 0;
+        for (size_t edge = 0; edge < g.edge_count(); edge++) {
+            total += g.weight(edge);
+            heaviest = std::max(heaviest, g.weight(edge));
+        }
+        if (this->delta <= 0) this->delta = g.edge_count() > 0 && total > 0 ? total / static_cast<double>(g.edge_count()) : 1.0;
+
+        // a relaxation from bucket i lands at most heaviest / delta buckets further, one spare for rounding
+        double span = std::ceil(heaviest / this->delta) + 2;
+        if (!(span <= static_cast<double>(max_buckets))) throw std::invalid_argument("DeltaStepping: delta is too small for the heaviest edge");
+        buckets.resize(static_cast<size_t>(span));
+    }
+
+    DeltaStepping(const DeltaStepping&) = delete;
+    DeltaStepping& operator=(const DeltaStepping&) = delete;
+
+    double bucket_width() const { return delta; }
+    size_t thread_count() const { return threads; }
+
+    // distances from src indexed by dense index (CompactGraph::index_of), INFINITY when unreachable
+    std::vector<double> run(size_t src) {
+        SearchRecorder recorder("delta_stepping", src);
+        for (std::atomic<uint64_t>& b : bits) {
+            b.store(to_bits(INFINITY), std::memory_order_relaxed);
+        }
+        for (std::vector<size_t>& b : buckets) {
+            b.clear();
+        }
+        queued = 0;
+
+        size_t source = g.index_of(src);
+        if (source != CompactGraph::npos) {
+            bits[source].store(to_bits(0), std::memory_order_relaxed);
+            bucket(0).push_back(source);
+            queued++;
+            recorder.push(1);
+        }
+        recorder.phase("setup");
+
+        std::vector<size_t> frontier, settled, improved;
+        for (size_t i = 0; queued > 0; i++) {
+            std::vector<size_t>& current = bucket(i);
+            settled.clear();
+            size_t first_round = round + 1;
+            while (!current.empty()) {
+                // take the live, distinct entries of bucket i - a vertex back for another light round is settled once
+                round++;
+                frontier.clear();
+                for (size_t v : current) {
+                    if (stamp[v] != round && bucket_index(distance(v)) == i) {
+                        if (stamp[v] < first_round) settled.push_back(v);
+                        stamp[v] = round;
+                        frontier.push_back(v);
+                    } else {
+                        recorder.stale();
+                    }
+                }
+                queued -= current.size();
+                current.clear();
+
+                recorder.relax(relax(frontier, true, improved));
+                file(improved, recorder);
+                recorder.phase("light");
+            }
+
+            // distances in bucket i are final now, heavy edges can only reach later buckets
+            recorder.settle(settled.size());
+            recorder.relax(relax(settled, false, improved));
+            file(improved, recorder);
+            recorder.phase("heavy");
+        }
+
+        std::vector<double> distances(bits.size());
+        for (size_t v = 0; v < bits.size(); v++) {
+            distances[v] = distance(v);
+        }
+        return distances;
+    }
+
+    private:
+    static uint64_t to_bits(double d) {
+        uint64_t b;
+        std::memcpy(&b, &d, sizeof b);
+        return b;
+    }
+
+    double distance(size_t v) const {
+        uint64_t b = bits[v].load(std::memory_order_relaxed);
+        double d;
+        std::memcpy(&d, &b, sizeof d);
+        return d;
+    }
+
+    size_t bucket_index(double d) const { return static_cast<size_t>(d / delta); }
+
+    std::vector<size_t>& bucket(size_t i) { return buckets[i % buckets.size()]; }
+
+    // lowers v to d if that is an improvement, true when this call made the change
+    bool lower(size_t v, double d) {
+        uint64_t candidate = to_bits(d);
+        uint64_t current = bits[v].load(std::memory_order_relaxed);
+        while (candidate < current) {
+            if (bits[v].compare_exchange_weak(current, candidate, std::memory_order_relaxed)) return true;
+        }
+        return false;
+    }
+
+    // both return the number of edges scanned, for SearchRecorder
+    size_t relax_range(const std::vector<size_t>& frontier, size_t first, size_t last, bool light, std::vector<size_t>& improved) {
+        size_t scanned = 0;
+        for (size_t i = first; i < last; i++) {
+            size_t u = frontier[i];
+            double base = distance(u);
+            scanned += g.edges_end(u) - g.edges_begin(u);
+            for (size_t edge = g.edges_begin(u); edge < g.edges_end(u); edge++) {
+                double w = g.weight(edge);
+                if ((w <= delta) != light) continue;
+                if (lower(g.target(edge), base + w)) improved.push_back(g.target(edge));
+            }
+        }
+        return scanned;
+    }
+
+    size_t relax(const std::vector<size_t>& frontier, bool light, std::vector<size_t>& improved) {
+        improved.clear();
+        size_t workers = std::min(pool.size(), frontier.size() / parallel_threshold + 1);
+        if (workers <= 1) return relax_range(frontier, 0, frontier.size(), light, improved);
+
+        std::vector<std::vector<size_t>> found(workers);
+        std::vector<size_t> scanned(workers, 0);
+        size_t chunk = (frontier.size() + workers - 1) / workers;
+        pool.run(workers, [this, &frontier, &found, &scanned, chunk, light](size_t t) {
+            size_t first = std::min(frontier.size(), t * chunk);
+            size_t last = std::min(frontier.size(), first + chunk);
+            scanned[t] = relax_range(frontier, first, last, light, found[t]);
+        });
+        size_t total = 0;
+        for (size_t t = 0; t < workers; t++) {
+            improved.insert(improved.end(), found[t].begin(), found[t].end());
+            total += scanned[t];
+        }
+        return total;
+    }
+
+    // put improved vertices in the bucket of their current distance - older entries go stale and are skipped
+    void file(const std::vector<size_t>& improved, SearchRecorder& recorder) {
+        for (size_t v : improved) {
+            std::vector<size_t>& b = bucket(bucket_index(distance(v)));
+            b.push_back(v);
+            queued++;
+            recorder.push(b.size());
+        }
+    }
+};
+
+// convenience wrapper - distances from src by dense index of g
+inline std::vector<double> delta_stepping(const CompactGraph& g, size_t src, double delta = 0, size_t threads = 0) {
+    DeltaStepping solver(g, delta, threads);
+    return solver.run(src);
+}
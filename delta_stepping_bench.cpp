@@ -0,0 +1,80 @@
+#include "delta_stepping.h"
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <string>
+
+// delta-stepping scaling across thread counts against sequential dijkstra - `make delta_stepping_bench`
+
+CompactGraph grid_graph(size_t side) {
+    // 4-neighbour grid built straight into CSR, rows come out sorted by target
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> weight(1, 100);
+    std::vector<size_t> ids(side * side), offsets(1, 0), targets;
+    std::vector<double> weights;
+    for (size_t n = 0; n < side * side; n++) {
+        ids[n] = n;
+        size_t r = n / side, c = n % side;
+        if (r > 0) { targets.push_back(n - side); weights.push_back(weight(rng)); }
+        if (c > 0) { targets.push_back(n - 1); weights.push_back(weight(rng)); }
+        if (c + 1 < side) { targets.push_back(n + 1); weights.push_back(weight(rng)); }
+        if (r + 1 < side) { targets.push_back(n + side); weights.push_back(weight(rng)); }
+        offsets.push_back(targets.size());
+    }
+    return CompactGraph(ids, offsets, targets, weights);
+}
+
+CompactGraph random_graph(size_t vertices, size_t degree) {
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<size_t> vertex(0, vertices - 1);
+    std::uniform_real_distribution<double> weight(1, 100);
+    std::vector<size_t> ids(vertices), offsets(1, 0), targets, row;
+    std::vector<double> weights;
+    for (size_t n = 0; n < vertices; n++) {
+        ids[n] = n;
+        row.clear();
+        for (size_t e = 0; e < degree; e++) {
+            row.push_back(vertex(rng));
+        }
+        std::sort(row.begin(), row.end());
+        row.erase(std::unique(row.begin(), row.end()), row.end());
+        for (size_t t : row) {
+            targets.push_back(t);
+            weights.push_back(weight(rng));
+        }
+        offsets.push_back(targets.size());
+    }
+    return CompactGraph(ids, offsets, targets, weights);
+}
+
+void run(const std::string& name, CompactGraph& g) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    g.dijkstra(0);
+    std::chrono::duration<double, std::milli> sequential = std::chrono::steady_clock::now() - start;
+    std::cout << name << ",dijkstra,1," << g.vertex_count() << "," << g.edge_count() << "," << sequential.count() << std::endl;
+
+    size_t hardware = std::max<size_t>(1, std::thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= hardware; threads *= 2) {
+        DeltaStepping solver(g, 0, threads);
+        start = std::chrono::steady_clock::now();
+        std::vector<double> d = solver.run(0);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+        size_t wrong = 0;
+        for (size_t v = 0; v < d.size(); v++) {
+            if (std::fabs(d[v] - g.distance(v)) > 1e-6 && d[v] != g.distance(v)) wrong++;
+        }
+        std::cout << name << ",delta_stepping," << threads << "," << g.vertex_count() << "," << g.edge_count() << ","
+                  << elapsed.count() << (wrong ? ",MISMATCH" : "") << std::endl;
+    }
+}
+
+int main() {
+    CompactGraph grid = grid_graph(1000);
+    CompactGraph random = random_graph(1000000, 8);
+
+    std::cout << "graph,algorithm,threads,vertices,edges,ms" << std::endl;
+    run("grid", grid);
+    run("random", random);
+    return 0;
+}
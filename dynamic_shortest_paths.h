@@ -0,0 +1,246 @@
+/*
+*   Single source shortest paths kept up to date while the graph changes (dynamic Dijkstra)
+*   Mutate the graph through this class and only the part of the shortest path tree that can change is redone:
+*     - a new or cheaper edge u -> v runs Dijkstra outwards from v, only as far as distances keep improving
+*     - a removed or dearer tree edge u -> v resets the subtree below v, seeds each of its vertices from its
+*       in-neighbours outside the subtree and runs Dijkstra inside it (Ramalingam-Reps style)
+*     - a removed or dearer non-tree edge changes nothing
+*   Changes made to the graph directly are not seen - call rebuild() afterwards. Weights must be non-negative -
+*   a negative one is refused with domain_error before the graph is touched.
+*/
+
+#pragma once
+#include "graph.h"
+#include "heaps.h"
+#include <vector>
+#include <cmath> // INFINITY
+#include <algorithm> // reverse
+#include <stdexcept> // domain_error
+
+class DynamicShortestPaths {
+    static constexpr size_t npos = Graph::npos;
+
+    Graph& g;
+    size_t src;
+    std::vector<double> distances; // indexed by vertex slot
+    std::vector<size_t> parents;   // indexed by vertex slot, npos for the source and unreachable vertices
+    std::vector<bool> affected;    // marks the subtree being repaired
+    std::vector<size_t> subtree;
+    BinaryHeap queue;
+    size_t touched_count;
+
+    public:
+    DynamicShortestPaths(Graph& g, size_t src)
+        : g{g}, src{src}, distances{}, parents{}, affected{}, subtree{}, queue{}, touched_count{0} {
+        rebuild();
+    }
+
+    DynamicShortestPaths(const DynamicShortestPaths&) = delete;
+    DynamicShortestPaths& operator=(const DynamicShortestPaths&) = delete;
+
+    size_t source() const { return src; }
+
+    // same queries as Graph::ShortestPaths, always reflecting the current graph
+    double distance(size_t id) const {
+        size_t slot = slot_of(id);
+        return slot == npos ? INFINITY : distances[slot];
+    }
+
+    bool reachable(size_t id) const { return distance(id) != INFINITY; }
+
+    size_t predecessor(size_t id) const {
+        size_t slot = slot_of(id);
+        if (slot == npos || parents[slot] == npos) return npos;
+        return g.slots[parents[slot]]->ID;
+    }
+
+    std::vector<size_t> path(size_t id) const {
+        std::vector<size_t> p;
+        size_t slot = slot_of(id);
+        if (slot == npos || distances[slot] == INFINITY) return p;
+        for (; slot != npos; slot = parents[slot]) {
+            p.push_back(g.slots[slot]->ID);
+        }
+        std::reverse(p.begin(), p.end());
+        return p;
+    }
+
+    // vertices reset or settled by the last change - what the repair cost compared to a full run
+    size_t touched() const { return touched_count; }
+
+    // full recomputation from the source
+    void rebuild() {
+        distances.assign(g.slots.size(), INFINITY);
+        parents.assign(g.slots.size(), npos);
+        affected.assign(g.slots.size(), false);
+        queue.clear(g.slots.size());
+        touched_count = 0;
+
+        size_t source = slot_of(src);
+        if (source == npos) return;
+        distances[source] = 0;
+        queue.push(source, 0);
+        propagate();
+    }
+
+    // graph mutators - same contracts as the Graph methods they forward to
+    bool add_vertex(size_t id) {
+        if (!g.add_vertex(id)) return false;
+        distances.push_back(id == src ? 0 : INFINITY); // the source may be added after the fact
+        parents.push_back(npos);
+        affected.push_back(false);
+        touched_count = 1;
+        return true;
+    }
+
+    bool add_edge(size_t from, size_t to, double weight = 1.0) {
+        require_non_negative(weight);
+        if (!g.add_edge(from, to, weight)) return false;
+        decrease(from, to, weight);
+        return true;
+    }
+
+    bool remove_edge(size_t from, size_t to) {
+        if (!g.remove_edge(from, to)) return false;
+        increase(from, to);
+        return true;
+    }
+
+    bool update_weight(size_t from, size_t to, double weight) {
+        require_non_negative(weight);
+        double old = g.cost(from, to);
+        if (!g.update_weight(from, to, weight)) return false;
+        touched_count = 0;
+        if (weight < old) decrease(from, to, weight);
+        else if (weight > old) increase(from, to);
+        return true;
+    }
+
+    bool remove_vertex(size_t id) {
+        size_t slot = slot_of(id);
+        if (slot == npos) return false;
+        if (id == src) { // nothing is reachable any more
+            g.remove_vertex(id);
+            rebuild();
+            return true;
+        }
+
+        touched_count = 0;
+        if (distances[slot] != INFINITY) collect(slot);
+        else subtree.clear(); // unreachable - nothing hangs below it, and the last change's subtree is done
+
+        // the graph moves its last vertex into the freed slot - do the same here
+        size_t last = g.slots.size() - 1;
+        g.remove_vertex(id);
+        if (slot != last) {
+            distances[slot] = distances[last];
+            parents[slot] = parents[last];
+            affected[slot] = affected[last];
+            for (const std::pair<const size_t, double>& adj_vertex : g.slots[slot]->adj_list) {
+                size_t child = g.vertex_at(adj_vertex.first)->index;
+                if (parents[child] == last) parents[child] = slot;
+            }
+        }
+        distances.pop_back();
+        parents.pop_back();
+        affected.pop_back();
+
+        size_t kept = 0;
+        for (size_t s : subtree) {
+            if (s == slot) continue; // the removed vertex
+            subtree[kept++] = s == last ? slot : s;
+        }
+        subtree.resize(kept);
+        repair();
+        return true;
+    }
+
+    private:
+    static void require_non_negative(double weight) {
+        if (weight < 0) throw std::domain_error("DynamicShortestPaths: negative edge weights are not supported");
+    }
+
+    size_t slot_of(size_t id) const {
+        const Graph::Vertex* vertex = g.find_vertex(id);
+        return vertex == nullptr ? npos : vertex->index;
+    }
+
+    // from -> to got cheaper or was added
+    void decrease(size_t from, size_t to, double weight) {
+        touched_count = 0;
+        size_t u = slot_of(from), v = slot_of(to);
+        if (distances[u] + weight >= distances[v]) return;
+        distances[v] = distances[u] + weight;
+        parents[v] = u;
+        queue.push(v, distances[v]);
+        propagate();
+    }
+
+    // from -> to got dearer or was removed - only matters if it is a tree edge
+    void increase(size_t from, size_t to) {
+        touched_count = 0;
+        size_t u = slot_of(from), v = slot_of(to);
+        if (parents[v] != u) return;
+        collect(v);
+        repair();
+    }
+
+    // marks root and every vertex below it in the shortest path tree and disconnects them
+    void collect(size_t root) {
+        subtree.clear();
+        subtree.push_back(root);
+        affected[root] = true;
+        for (size_t i = 0; i < subtree.size(); i++) {
+            size_t x = subtree[i];
+            for (const std::pair<const size_t, double>& adj_vertex : g.slots[x]->adj_list) {
+                size_t child = g.vertex_at(adj_vertex.first)->index;
+                if (parents[child] == x && !affected[child]) {
+                    affected[child] = true;
+                    subtree.push_back(child);
+                }
+            }
+        }
+        for (size_t x : subtree) {
+            distances[x] = INFINITY;
+            parents[x] = npos;
+        }
+        touched_count += subtree.size();
+    }
+
+    // seeds the marked subtree from the rest of the tree, whose distances are still exact, then settles it
+    void repair() {
+        for (size_t x : subtree) {
+            for (const std::pair<const size_t, double>& in_vertex : g.slots[x]->in_list) {
+                size_t z = g.vertex_at(in_vertex.first)->index;
+                if (!affected[z] && distances[z] + in_vertex.second < distances[x]) {
+                    distances[x] = distances[z] + in_vertex.second;
+                    parents[x] = z;
+                }
+            }
+            if (distances[x] != INFINITY) queue.push(x, distances[x]);
+        }
+        for (size_t x : subtree) {
+            affected[x] = false;
+        }
+        propagate();
+    }
+
+    // Dijkstra from whatever is queued, stopping where distances stop improving
+    void propagate() {
+        while (!queue.empty()) {
+            std::pair<double, size_t> current = queue.pop();
+            if (current.first > distances[current.second]) continue; // stale entry
+            touched_count++;
+
+            for (const std::pair<const size_t, double>& adj_vertex : g.slots[current.second]->adj_list) {
+                size_t next = g.vertex_at(adj_vertex.first)->index;
+                double candidate = current.first + adj_vertex.second;
+                if (candidate < distances[next]) {
+                    distances[next] = candidate;
+                    parents[next] = current.second;
+                    queue.push(next, candidate);
+                }
+            }
+        }
+    }
+};
@@ -5,193 +5,1059 @@
 
 #pragma once
 #include <unordered_map>
+#include <unordered_set> // remove_vertices
 #include <cmath> // INFINITY
 #include <queue> // dijkstra
 #include <stack> // print_shortest_path
 #include <iostream> // print_shortest_path
+#include <vector> // freeze, shortest_paths
+#include <algorithm> // freeze, shortest_paths
+#include <memory> // unique_ptr
+#include <string> // save, open_mapped
+#include <type_traits> // conditional, is_integral
+#include <stdexcept> // invalid_argument, domain_error
+#include <set> // k_shortest_paths
+#include <deque> // bellman_ford
+#include "arena.h"
+#include "compact_graph.h"
+#include "heaps.h"
+#include "parallel.h"
+#include "search_stats.h"
+
+// adjacency storage policy - Storage::map<Id, Weight> holds the edges of one vertex (neighbour ID -> weight) and has to
+// behave like std::unordered_map (find, insert, erase, at, reserve), taking an ArenaAllocator for the graph's arena
+struct HashStorage {
+    template <class Id, class Weight>
+    using map = std::unordered_map<Id, Weight, std::hash<Id>, std::equal_to<Id>, ArenaAllocator<std::pair<const Id, Weight>>>;
+};
+
+/*
+ *  VertexId is any integer type for the vertex IDs and Weight any arithmetic type for the edge weights - narrow
+ *  types (uint32_t, float) shrink every adjacency node. Distances are doubles whatever Weight is, which keeps them
+ *  exact for integer weights as long as path lengths stay below 2^53. Integer weights must be non-negative and
+ *  make the searches default to RadixHeap, a monotone bucket queue, instead of the comparison based BinaryHeap.
+ *  Graph is the original size_t / double graph.
+*/
+template <class VertexId = size_t, class Weight = double, class Storage = HashStorage>
+class BasicGraph {
+    static_assert(std::is_integral<VertexId>::value, "BasicGraph: VertexId must be an integer type");
+    static_assert(std::is_arithmetic<Weight>::value, "BasicGraph: Weight must be an arithmetic type");
+
+    friend class DynamicShortestPaths; // repairs its tree through the adjacency maps directly
+
+    // adjacency maps allocate their nodes and bucket arrays from the graph's arena
+    typedef typename Storage::template map<VertexId, Weight> EdgeMap;
+    typedef typename EdgeMap::value_type Adjacent; // (neighbour ID, weight)
 
-class Graph {
     struct Vertex {
-        size_t ID;
-        std::unordered_map<size_t, double> adj_list;
+        VertexId ID;
+        size_t index; // dense slot in BasicGraph::slots, used to index per-query scratch arrays
+        EdgeMap adj_list;
+        EdgeMap in_list; // reverse index: source ID -> weight of every incoming edge
         bool visited;
         double distance;
         Vertex* predecessor;
+        bool located; // x and y are set - optional, used by the built-in A* heuristics
+        double x;
+        double y;
 
-        Vertex() : ID{}, adj_list{}, visited{}, distance{}, predecessor{} {}
-        explicit Vertex(size_t ID) : ID{ID}, adj_list{}, visited{false}, distance{0}, predecessor{nullptr} {}
+        Vertex(VertexId ID, size_t index, Arena* arena)
+            : ID{ID}, index{index}, adj_list(typename EdgeMap::allocator_type(arena)), in_list(typename EdgeMap::allocator_type(arena)),
+              visited{false}, distance{0}, predecessor{nullptr}, located{false}, x{0}, y{0} {}
         bool operator<(const Vertex& other) { return this->distance < other.distance; }
 
+        // copies everything but predecessor, which has to point into the owning graph - see BasicGraph::copy
         void copy(const Vertex& other) {
             ID = other.ID;
+            index = other.index;
             visited = other.visited;
             adj_list = other.adj_list;
+            in_list = other.in_list;
             distance = other.distance;
-            other.predecessor ? predecessor = new Vertex(other.predecessor->ID) : predecessor = nullptr;
+            located = other.located;
+            x = other.x;
+            y = other.y;
         }
 
-        Vertex(const Vertex& other) : Vertex() { copy(other); }
-        Vertex& operator=(const Vertex& rhs) { *this = Vertex(rhs); return *this; }
+        // vertices only live inside a graph's arena and are copied with copy()
+        Vertex(const Vertex&) = delete;
+        Vertex& operator=(const Vertex&) = delete;
+    };
+
+    typedef std::unordered_map<VertexId, Vertex*> VertexMap;
+
+    public:
+    // how vertices are found by ID - chosen at construction
+    enum IdMode {
+        sparse_ids, // any IDs, hashed
+        dense_ids   // IDs are small non-negative integers (ideally 0..N-1) indexing a vector, no hashing
     };
 
-    std::unordered_map<size_t, Vertex*> graph;
+    private:
+    std::unique_ptr<Arena> arena; // owns every Vertex and adjacency node, behind a pointer so its address is stable - null once moved from
+    IdMode mode;
+    VertexMap graph; // sparse_ids only
+    std::vector<Vertex*> by_id; // dense_ids only - by_id[id] is the vertex with that ID, nullptr for a gap
+    std::vector<Vertex*> slots; // dense view of graph - slots[v->index] == v, kept compact on removal
     size_t edges; // number of edges counter - want to return edge_count in constant time
+    size_t negative_edges; // edges weighing less than zero, which the Dijkstra based searches refuse
+    size_t degree_hint; // adjacency buckets reserved for each new vertex, set by reserve()
+    size_t mutations; // bumped by every change to vertices or edges, so cached results can tell they are stale
     
     public:
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    typedef VertexId id_type;
+    typedef Weight weight_type;
+    // queue the searches use unless told otherwise - integer weights allow a monotone bucket queue
+    typedef typename std::conditional<std::is_integral<Weight>::value, RadixHeap, BinaryHeap>::type DefaultQueue;
+
+    // a single route - vertices from source to destination inclusive, empty with distance INFINITY when there is none
+    struct Path {
+        double distance;
+        std::vector<VertexId> vertices;
+
+        Path() : distance{INFINITY}, vertices{} {}
+    };
+
+    // result of a const shortest path query - valid until the graph is modified
+    class ShortestPaths {
+        friend class BasicGraph;
+        const BasicGraph* owner;
+        VertexId src;
+        size_t epoch;                     // bumped per query so the arrays below never need clearing
+        std::vector<double> distances;    // indexed by vertex slot
+        std::vector<size_t> predecessors; // indexed by vertex slot, npos for none
+        std::vector<size_t> stamps;       // 2 * epoch once labeled by this query, 2 * epoch + 1 once settled
+        std::vector<size_t> origins;      // indexed by vertex slot, slot of the source it was reached from - multi-source only
+        bool multi;                       // origins is filled in by the current query
+
+        void reset(const BasicGraph* graph, VertexId source, bool track_origins = false) {
+            owner = graph;
+            src = source;
+            multi = track_origins;
+            epoch++;
+            if (stamps.size() < graph->slots.size()) {
+                distances.resize(graph->slots.size(), INFINITY);
+                predecessors.resize(graph->slots.size(), npos);
+                stamps.resize(graph->slots.size(), 0);
+            }
+            if (multi && origins.size() < graph->slots.size()) origins.resize(graph->slots.size(), npos);
+        }
+
+        bool labeled(size_t slot) const { return stamps[slot] >= 2 * epoch; }
+        bool settled(size_t slot) const { return stamps[slot] == 2 * epoch + 1; }
+
+        void label(size_t slot, double distance, size_t predecessor) {
+            distances[slot] = distance;
+            predecessors[slot] = predecessor;
+            stamps[slot] = 2 * epoch;
+        }
+
+        // slot of a vertex settled by the last query, npos otherwise
+        size_t slot_of(VertexId id) const {
+            if (owner == nullptr || !owner->contains_vertex(id)) return npos;
+            size_t slot = owner->vertex_at(id)->index;
+            return slot < stamps.size() && settled(slot) ? slot : npos;
+        }
+
+        public:
+        ShortestPaths()
+            : owner{nullptr}, src{static_cast<VertexId>(npos)}, epoch{0}, distances{}, predecessors{}, stamps{}, origins{}, multi{false} {}
+        ShortestPaths(const ShortestPaths&) = default;
+        ShortestPaths& operator=(const ShortestPaths&) = default;
+
+        // source of the query - the first one listed for a multi-source query
+        size_t source() const { return src; }
+
+        // source whose shortest path tree id ended up in (widened to size_t), npos when id is unreachable
+        size_t nearest_source(VertexId id) const {
+            size_t slot = slot_of(id);
+            if (slot == npos) return npos;
+            return multi ? owner->slots[origins[slot]]->ID : src;
+        }
+
+        // exact distance to id, INFINITY when id is unreachable or was not settled before the search stopped
+        double distance(VertexId id) const {
+            size_t slot = slot_of(id);
+            return slot == npos ? INFINITY : distances[slot];
+        }
+
+        bool reachable(VertexId id) const { return slot_of(id) != npos; }
+
+        // heap memory held by the result arrays
+        size_t memory_bytes() const {
+            return distances.capacity() * sizeof(double) + (predecessors.capacity() + stamps.capacity() + origins.capacity()) * sizeof(size_t);
+        }
+
+        // ID of the vertex before id on its shortest path, npos for the source and unreachable vertices
+        size_t predecessor(VertexId id) const {
+            size_t slot = slot_of(id);
+            if (slot == npos || predecessors[slot] == npos) return npos;
+            return owner->slots[predecessors[slot]]->ID;
+        }
+
+        // vertex IDs from the (nearest) source to id inclusive, empty when id is unreachable
+        std::vector<VertexId> path(VertexId id) const {
+            std::vector<VertexId> p;
+            for (size_t slot = slot_of(id); slot != npos; slot = predecessors[slot]) {
+                p.push_back(owner->slots[slot]->ID);
+            }
+            std::reverse(p.begin(), p.end());
+            return p;
+        }
+    };
+
     // constructor
-    Graph() : graph{}, edges{0} {}
+    explicit BasicGraph(IdMode mode = sparse_ids)
+        : arena{new Arena()}, mode{mode}, graph{}, by_id{}, slots{}, edges{0}, negative_edges{0}, degree_hint{0}, mutations{0} {}
 
-    // rule of three
+    // rule of five
     void clear() {
-        for (const std::pair<size_t, Vertex*>& pair : graph) {
-            delete pair.second;
+        // with a pooled arena every vertex and adjacency node goes away with the arena's slabs in one sweep
+        if (!Arena::pooled) {
+            for (Vertex* vertex : slots) {
+                destroy_vertex(vertex);
+            }
         }
         graph.clear();
+        by_id.clear();
+        slots.clear();
+        if (arena) arena->release();
         edges = 0;
+        negative_edges = 0;
+        mutations++;
     }
 
-    void copy(const Graph& source) {
+    void copy(const BasicGraph& source) {
+        mode = source.mode;
         edges = source.edges;
-        for (const std::pair<size_t, Vertex*>& pair : source.graph) {
-            Vertex* vertex = new Vertex(*pair.second);
-            graph.insert(std::pair<size_t, Vertex*>(pair.first, vertex));
+        negative_edges = source.negative_edges;
+        graph.reserve(source.graph.size());
+        by_id.assign(source.by_id.size(), nullptr);
+        slots.resize(source.slots.size());
+        for (const Vertex* original : source.slots) {
+            Vertex* vertex = create_vertex(original->ID, original->index);
+            vertex->copy(*original);
+            if (mode == dense_ids) by_id[static_cast<size_t>(vertex->ID)] = vertex;
+            else graph.insert(typename VertexMap::value_type(vertex->ID, vertex));
+            slots[vertex->index] = vertex;
+        }
+
+        // predecessors point at the copies, slots line up one to one
+        for (const Vertex* original : source.slots) {
+            slots[original->index]->predecessor = original->predecessor ? slots[original->predecessor->index] : nullptr;
         }
     }
 
-    Graph(const Graph& source) : Graph() { copy(source); }
-    ~Graph() { clear(); }
-    Graph& operator=(const Graph& rhs) {
+    BasicGraph(const BasicGraph& source) : BasicGraph(source.mode) { copy(source); }
+    ~BasicGraph() { clear(); }
+    BasicGraph& operator=(const BasicGraph& rhs) {
         if (this != &rhs) {
             clear();
             copy(rhs);
         }
         return *this;
     }
+
+    // moves hand over the arena, so no vertex or adjacency node is copied - the source is left empty
+    BasicGraph(BasicGraph&& source) noexcept
+        : arena{std::move(source.arena)}, mode{source.mode}, graph{std::move(source.graph)}, by_id{std::move(source.by_id)},
+          slots{std::move(source.slots)}, edges{source.edges}, negative_edges{source.negative_edges}, degree_hint{source.degree_hint},
+          mutations{source.mutations} {
+        source.forget();
+    }
+
+    BasicGraph& operator=(BasicGraph&& rhs) noexcept {
+        if (this != &rhs) {
+            clear();
+            arena = std::move(rhs.arena);
+            mode = rhs.mode;
+            graph = std::move(rhs.graph);
+            by_id = std::move(rhs.by_id);
+            slots = std::move(rhs.slots);
+            edges = rhs.edges;
+            negative_edges = rhs.negative_edges;
+            degree_hint = rhs.degree_hint;
+            mutations = std::max(mutations, rhs.mutations) + 1; // never a version this graph had before
+            rhs.forget();
+        }
+        return *this;
+    }
     
     // capacity
-    size_t vertex_count() const { return graph.size(); }
+    size_t vertex_count() const { return slots.size(); }
     size_t edge_count() const { return edges; }
+    bool has_negative_weights() const { return negative_edges > 0; } // kept up to date by every edge change, O(1)
+    size_t arena_bytes() const { return arena ? arena->bytes_reserved() : 0; } // memory held for vertices and adjacency maps
+    size_t version() const { return mutations; } // changes whenever a vertex or edge is added, removed or reweighted
+    IdMode id_mode() const { return mode; }
 
     // element access
-    bool contains_vertex(size_t id) const {
-        return graph.find(id) != graph.end();
+    bool contains_vertex(VertexId id) const {
+        return find_vertex(id) != nullptr;
     }
 
-    bool contains_edge(size_t src, size_t dest) const {
+    bool contains_edge(VertexId src, VertexId dest) const {
         // confirm the two vertices exist
         if (!contains_vertex(src) || !contains_vertex(dest)) return false;
 
         // look for edge
-        Vertex* source = graph.at(src);
+        Vertex* source = vertex_at(src);
         return source->adj_list.find(dest) != source->adj_list.end();
     }
 
-    double cost(size_t src, size_t dest) const {
+    double cost(VertexId src, VertexId dest) const {
         if (!contains_edge(src, dest)) return INFINITY; // cost to vertex which is not connected is represented as INFINITY
         // edge exist, get cost
-        Vertex* source = graph.at(src);
+        Vertex* source = vertex_at(src);
         return source->adj_list.at(dest);
     }
 
-    bool add_vertex(size_t id) {
-        if (contains_vertex(id)) return false;
-        return graph.insert(std::pair<size_t, Vertex*>{id, new Vertex(id)}).second;
+    // edge list entry for from_edges
+    struct Edge {
+        VertexId src;
+        VertexId dest;
+        Weight weight;
+    };
+
+    void reserve(size_t vertices, size_t expected_edges = 0) {
+        // sizes the vertex table once and pre-sizes each new vertex's adjacency maps for the average degree
+        if (mode == dense_ids) by_id.reserve(vertices);
+        else graph.reserve(vertices);
+        slots.reserve(vertices);
+        degree_hint = vertices > 0 ? expected_edges / vertices : 0;
     }
 
-    bool add_edge(size_t src, size_t dest, double weight = 1.0) {
-        // confirm vertices exist
-        if (!contains_vertex(src) || !contains_vertex(dest)) return false;
+    bool add_vertex(VertexId id) {
+        if (mode == dense_ids) {
+            // the table grows to the largest ID, gaps stay null
+            size_t position = static_cast<size_t>(id);
+            if (position >= by_id.size()) by_id.resize(position + 1, nullptr);
+            if (by_id[position] != nullptr) return false;
+            by_id[position] = create_vertex(id, slots.size());
+            slots.push_back(by_id[position]);
+            mutations++;
+            return true;
+        }
 
-        // confirm edge exist
-        if (contains_edge(src, dest)) return false;
+        // a single hash lookup - the placeholder is filled in once the insert is known to be new
+        std::pair<typename VertexMap::iterator, bool> inserted = graph.insert(typename VertexMap::value_type{id, nullptr});
+        if (!inserted.second) return false;
+        inserted.first->second = create_vertex(id, slots.size());
+        slots.push_back(inserted.first->second);
+        mutations++;
+        return true;
+    }
 
-        // add the edge
-        Vertex* source = graph.at(src);
-        source->adj_list.insert(std::pair<size_t, double>{dest, weight});
+    bool add_edge(VertexId src, VertexId dest, Weight weight = 1) {
+        // confirm vertices exist
+        Vertex* source = find_vertex(src);
+        Vertex* destination = find_vertex(dest);
+        if (source == nullptr || destination == nullptr) return false;
+
+        // add the edge unless it exists
+        if (!source->adj_list.insert(Adjacent{dest, weight}).second) return false;
+        destination->in_list.insert(Adjacent{src, weight});
         edges++;
+        if (negative(weight)) negative_edges++;
+        mutations++;
 
         return true;
     }
 
-    bool remove_edge(size_t src, size_t dest) {
+    bool remove_edge(VertexId src, VertexId dest) {
         // confirm edge exists
-        if (!contains_edge(src, dest)) return false;
+        Vertex* source = find_vertex(src);
+        if (source == nullptr) return false;
+        typename EdgeMap::iterator edge = source->adj_list.find(dest);
+        if (edge == source->adj_list.end()) return false;
+        if (negative(edge->second)) negative_edges--;
+        source->adj_list.erase(edge);
 
-        // remove the edge
-        Vertex* source = graph.at(src);
-        source->adj_list.erase(dest);
+        // an existing edge means dest exists too; a dijkstra() predecessor is always an in-neighbour
+        Vertex* destination = vertex_at(dest);
+        destination->in_list.erase(src);
+        if (destination->predecessor == source) destination->predecessor = nullptr;
         edges--;
+        mutations++;
+
+        return true;
+    }
 
+    bool update_weight(VertexId src, VertexId dest, Weight weight) {
+        // changes the weight of an existing edge, false when there is no such edge
+        Vertex* source = find_vertex(src);
+        if (source == nullptr) return false;
+        typename EdgeMap::iterator edge = source->adj_list.find(dest);
+        if (edge == source->adj_list.end()) return false;
+
+        if (negative(edge->second)) negative_edges--;
+        if (negative(weight)) negative_edges++;
+        edge->second = weight;
+        vertex_at(dest)->in_list.at(src) = weight;
+        mutations++;
         return true;
     }
 
-    bool remove_vertex(size_t id) {
+    static BasicGraph from_edges(std::vector<Edge> edge_list, const std::vector<VertexId>& vertices = std::vector<VertexId>(),
+                                 IdMode mode = sparse_ids) {
+        /*
+         *  builds a graph in one pass: vertices are every ID in vertices plus every edge endpoint, edges are
+         *  sorted once and repeated (src, dest) pairs keep their first weight, like repeated add_edge calls would
+         *  every adjacency map is sized for its exact degree before it is filled, so nothing rehashes
+        */
+        std::stable_sort(edge_list.begin(), edge_list.end(), [](const Edge& a, const Edge& b) {
+            return a.src < b.src || (a.src == b.src && a.dest < b.dest);
+        });
+        edge_list.erase(std::unique(edge_list.begin(), edge_list.end(), [](const Edge& a, const Edge& b) {
+            return a.src == b.src && a.dest == b.dest;
+        }), edge_list.end());
+
+        // edge indices grouped by destination, so the reverse index is filled one vertex at a time too
+        std::vector<std::pair<VertexId, size_t>> by_dest(edge_list.size());
+        for (size_t e = 0; e < edge_list.size(); e++) {
+            by_dest[e] = std::pair<VertexId, size_t>(edge_list[e].dest, e);
+        }
+        std::sort(by_dest.begin(), by_dest.end());
+
+        std::vector<VertexId> ids(vertices);
+        for (size_t e = 0; e < edge_list.size(); e++) {
+            if (e == 0 || edge_list[e].src != edge_list[e - 1].src) ids.push_back(edge_list[e].src);
+            if (e == 0 || by_dest[e].first != by_dest[e - 1].first) ids.push_back(by_dest[e].first);
+        }
+        std::sort(ids.begin(), ids.end());
+        ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+        BasicGraph g(mode);
+        g.reserve(mode == dense_ids && !ids.empty() ? static_cast<size_t>(ids.back()) + 1 : ids.size());
+        for (VertexId id : ids) {
+            g.add_vertex(id);
+        }
+
+        // both passes walk runs of equal endpoints - one lookup and one exact reserve per run
+        for (size_t first = 0, last = 0; first < edge_list.size(); first = last) {
+            while (last < edge_list.size() && edge_list[last].src == edge_list[first].src) last++;
+            Vertex* source = g.vertex_at(edge_list[first].src);
+            source->adj_list.reserve(last - first);
+            for (size_t e = first; e < last; e++) {
+                source->adj_list.insert(Adjacent{edge_list[e].dest, edge_list[e].weight});
+                if (negative(edge_list[e].weight)) g.negative_edges++;
+            }
+        }
+        for (size_t first = 0, last = 0; first < by_dest.size(); first = last) {
+            while (last < by_dest.size() && by_dest[last].first == by_dest[first].first) last++;
+            Vertex* destination = g.vertex_at(by_dest[first].first);
+            destination->in_list.reserve(last - first);
+            for (size_t e = first; e < last; e++) {
+                const Edge& edge = edge_list[by_dest[e].second];
+                destination->in_list.insert(Adjacent{edge.src, edge.weight});
+            }
+        }
+        g.edges = edge_list.size();
+        return g;
+    }
+
+    bool remove_vertex(VertexId id) {
         // confirm vertex exist
         if (!contains_vertex(id)) return false;
+        Vertex* source = vertex_at(id);
 
-        // remove all incoming edges
-        for (const std::pair<size_t, Vertex*>& pair : graph) {
-            if (contains_edge(pair.first, id)) remove_edge(pair.first, id);
+        // remove all incoming edges - the reverse index names their sources, so this is O(in-degree)
+        for (const Adjacent& in_vertex : source->in_list) {
+            if (in_vertex.first == id) continue; // self loop, removed with the outgoing edges
+            vertex_at(in_vertex.first)->adj_list.erase(id);
+            edges--;
+            if (negative(in_vertex.second)) negative_edges--;
         }
 
-        // remove all outgoing edges
-        Vertex* source = graph.at(id);
+        // remove all outgoing edges - and the dijkstra() predecessors that would dangle, which are only found there
         edges -= source->adj_list.size(); // update edges counter
-        source->adj_list.clear();
+        for (const Adjacent& adj_vertex : source->adj_list) {
+            Vertex* next = vertex_at(adj_vertex.first);
+            if (adj_vertex.first != id) next->in_list.erase(id);
+            if (next->predecessor == source) next->predecessor = nullptr;
+            if (negative(adj_vertex.second)) negative_edges--;
+        }
 
         // remove requested vertex
-        delete graph.at(id);
-        graph.erase(id);
+        release_slot(source);
+        destroy_vertex(source);
+        unindex_vertex(id);
+        mutations++;
+
+        return true;
+    }
+
+    template <class Range>
+    size_t remove_vertices(const Range& ids) {
+        /*
+         *  removes every vertex of ids (any range of IDs, missing and repeated IDs are ignored) in one pass
+         *  edges between two removed vertices are dropped without touching either side's maps
+         *  returns the number of vertices removed
+        */
+        std::unordered_set<VertexId> doomed;
+        for (VertexId id : ids) {
+            if (contains_vertex(id)) doomed.insert(id);
+        }
 
+        for (VertexId id : doomed) {
+            Vertex* source = vertex_at(id);
+            for (const Adjacent& in_vertex : source->in_list) {
+                if (doomed.count(in_vertex.first)) continue; // counted with that vertex's outgoing edges
+                vertex_at(in_vertex.first)->adj_list.erase(id);
+                edges--;
+                if (negative(in_vertex.second)) negative_edges--;
+            }
+
+            edges -= source->adj_list.size();
+            for (const Adjacent& adj_vertex : source->adj_list) {
+                Vertex* next = vertex_at(adj_vertex.first);
+                if (!doomed.count(adj_vertex.first)) next->in_list.erase(id);
+                if (next->predecessor == source) next->predecessor = nullptr;
+                if (negative(adj_vertex.second)) negative_edges--;
+            }
+        }
+
+        for (VertexId id : doomed) {
+            Vertex* source = vertex_at(id);
+            release_slot(source);
+            destroy_vertex(source);
+            unindex_vertex(id);
+        }
+        if (!doomed.empty()) mutations++;
+        return doomed.size();
+    }
+
+    // coordinates
+    bool set_coordinates(VertexId id, double x, double y) {
+        if (!contains_vertex(id)) return false;
+        Vertex* vertex = vertex_at(id);
+        vertex->located = true;
+        vertex->x = x;
+        vertex->y = y;
         return true;
     }
 
+    bool has_coordinates(VertexId id) const {
+        return contains_vertex(id) && vertex_at(id)->located;
+    }
+
+    std::pair<double, double> coordinates(VertexId id) const {
+        if (!has_coordinates(id)) return std::pair<double, double>(NAN, NAN);
+        return std::pair<double, double>(vertex_at(id)->x, vertex_at(id)->y);
+    }
+
+    /*
+     *  built-in A* heuristics - straight line (or grid) distance to dest multiplied by scale
+     *  admissible as long as every edge weight is at least scale times the distance between its endpoints
+     *  vertices without coordinates get an estimate of 0, which is always admissible
+    */
+    class EuclideanHeuristic {
+        const BasicGraph* owner;
+        bool located;
+        double x, y, scale;
+
+        public:
+        EuclideanHeuristic(const BasicGraph& g, VertexId dest, double scale)
+            : owner{&g}, located{g.has_coordinates(dest)}, x{g.coordinates(dest).first}, y{g.coordinates(dest).second}, scale{scale} {}
+        EuclideanHeuristic(const EuclideanHeuristic&) = default;
+        EuclideanHeuristic& operator=(const EuclideanHeuristic&) = default;
+
+        double operator()(VertexId id) const {
+            if (!located) return 0;
+            const Vertex* vertex = owner->vertex_at(id);
+            return vertex->located ? scale * std::hypot(vertex->x - x, vertex->y - y) : 0;
+        }
+    };
+
+    class ManhattanHeuristic {
+        const BasicGraph* owner;
+        bool located;
+        double x, y, scale;
+
+        public:
+        ManhattanHeuristic(const BasicGraph& g, VertexId dest, double scale)
+            : owner{&g}, located{g.has_coordinates(dest)}, x{g.coordinates(dest).first}, y{g.coordinates(dest).second}, scale{scale} {}
+        ManhattanHeuristic(const ManhattanHeuristic&) = default;
+        ManhattanHeuristic& operator=(const ManhattanHeuristic&) = default;
+
+        double operator()(VertexId id) const {
+            if (!located) return 0;
+            const Vertex* vertex = owner->vertex_at(id);
+            return vertex->located ? scale * (std::fabs(vertex->x - x) + std::fabs(vertex->y - y)) : 0;
+        }
+    };
+
+    EuclideanHeuristic euclidean_heuristic(VertexId dest, double scale = 1.0) const { return EuclideanHeuristic(*this, dest, scale); }
+    ManhattanHeuristic manhattan_heuristic(VertexId dest, double scale = 1.0) const { return ManhattanHeuristic(*this, dest, scale); }
+
+    // snapshot
+    CompactGraph freeze() const {
+        /*
+         *  builds an immutable CSR copy of the current graph for read-mostly workloads
+         *  vertices get dense indices in ascending ID order; later changes to this graph are not reflected
+        */
+        std::vector<size_t> ids;
+        ids.reserve(slots.size());
+        for (const Vertex* vertex : slots) {
+            ids.push_back(static_cast<size_t>(vertex->ID));
+        }
+        std::sort(ids.begin(), ids.end());
+
+        std::unordered_map<size_t, size_t> index; // original ID -> dense index
+        index.reserve(ids.size());
+        for (size_t i = 0; i < ids.size(); i++) {
+            index.insert(std::pair<size_t, size_t>(ids[i], i));
+        }
+
+        std::vector<size_t> offsets(ids.size() + 1, 0);
+        std::vector<size_t> targets;
+        std::vector<double> weights;
+        targets.reserve(edges);
+        weights.reserve(edges);
+
+        std::vector<std::pair<size_t, double>> row;
+        for (size_t i = 0; i < ids.size(); i++) {
+            // rows are sorted by destination so CompactGraph::contains_edge can binary search them
+            row.clear();
+            for (const Adjacent& adj_vertex : vertex_at(ids[i])->adj_list) {
+                row.push_back(std::pair<size_t, double>(index.at(adj_vertex.first), adj_vertex.second));
+            }
+            std::sort(row.begin(), row.end());
+
+            for (const std::pair<size_t, double>& edge : row) {
+                targets.push_back(edge.first);
+                weights.push_back(edge.second);
+            }
+            offsets[i + 1] = targets.size();
+        }
+
+        return CompactGraph(std::move(ids), std::move(offsets), std::move(targets), std::move(weights));
+    }
+
+    // binary snapshot on disk - see CompactGraph::save for the layout
+    void save(const std::string& path) const { freeze().save(path); }
+
+    // read-only view of a file written by save, queried in place without loading it into a Graph
+    static CompactGraph open_mapped(const std::string& path) { return CompactGraph::open_mapped(path); }
+
     // dijkstra methods
-    void dijkstra(size_t src) {
-        // confirm the pre condition (distance is infinity for all and no predecessor)
-        for (const std::pair<size_t, Vertex*>& pair : graph) {
-            pair.second->distance = INFINITY;
-            pair.second->predecessor = nullptr;
-            pair.second->visited = false;
+    void dijkstra(VertexId src) {
+        /*
+         *  stores the result in the vertices for distance() and print_shortest_path()
+         *  prefer shortest_paths() below when querying from several threads or several sources at once
+        */
+        ShortestPaths result;
+        shortest_paths(src, result);
+
+        for (Vertex* vertex : slots) {
+            bool settled = result.settled(vertex->index);
+            vertex->visited = settled;
+            vertex->distance = settled ? result.distances[vertex->index] : INFINITY;
+            size_t pred = settled ? result.predecessors[vertex->index] : npos;
+            vertex->predecessor = pred == npos ? nullptr : slots[pred];
         }
+    }
 
-        if (!contains_vertex(src)) return; // confirm source vertex exists
+    /*
+     *  const dijkstra - does not touch the vertices, so any number of threads may query the same graph at once
+     *  Queue picks the priority queue from heaps.h, e.g. shortest_paths<DaryHeap<4>>(src) or shortest_paths<RadixHeap>(src)
+    */
+    template <class Queue = DefaultQueue>
+    ShortestPaths shortest_paths(VertexId src) const {
+        ShortestPaths result;
+        shortest_paths<Queue>(src, result);
+        return result;
+    }
 
-        // finish initialization
-        graph.at(src)->distance = 0;
-        std::priority_queue<std::pair<double, Vertex*>, std::vector<std::pair<double, Vertex*>>, std::greater<std::pair<double, Vertex*>>> q;
-        q.push(std::pair<double, Vertex*>(0, graph.at(src)));
+    template <class Queue = DefaultQueue>
+    void shortest_paths(VertexId src, ShortestPaths& result) const {
+        /*
+         *  reuses the buffers already held by result and a per-thread queue, so repeated
+         *  queries from the same thread into the same result object do not allocate
+        */
+        search<Queue>(&src, nullptr, 1, nullptr, 0, INFINITY, result);
+    }
 
-        while (!q.empty()) {
-            // grab an unknown vertex that has minimum distance over all unknown vertices
-            std::pair<double, Vertex*> current = q.top();
-            q.pop();
+    /*
+     *  multi-source dijkstra - one search seeded with every source, each starting at its offset (0 without offsets)
+     *  every vertex ends up with the distance to its nearest source, that source (nearest_source) and the predecessor
+     *  towards it, so a nearest facility query or Voronoi partition of the whole graph costs one search instead of k
+     *  offsets must be empty or match sources one to one and be non-negative (-0.0 counts as 0); missing sources are ignored
+     *  on equal distances the source listed first wins
+    */
+    template <class Queue = DefaultQueue>
+    ShortestPaths multi_source_shortest_paths(const std::vector<VertexId>& sources, const std::vector<double>& offsets = std::vector<double>()) const {
+        ShortestPaths result;
+        multi_source_shortest_paths<Queue>(sources, offsets, result);
+        return result;
+    }
 
-            if (current.second->visited) continue; // shortest path is known
-            current.second->visited = true;
+    template <class Queue = DefaultQueue>
+    void multi_source_shortest_paths(const std::vector<VertexId>& sources, const std::vector<double>& offsets, ShortestPaths& result) const {
+        if (!offsets.empty() && offsets.size() != sources.size()) {
+            throw std::invalid_argument("multi_source_shortest_paths: offsets must be empty or one per source");
+        }
+        for (double offset : offsets) {
+            if (!(offset >= 0)) throw std::invalid_argument("multi_source_shortest_paths: offsets must be non-negative"); // NaN too
+        }
+        search<Queue>(sources.data(), offsets.empty() ? nullptr : offsets.data(), sources.size(), nullptr, 0, INFINITY, result, true);
+    }
 
-            double currDistance;
-            // update the distance for all vertices adjacent to current
-            for (const std::pair<size_t, double>& adj_vertex : current.second->adj_list) {
-                currDistance = graph.at(adj_vertex.first)->distance;
-                if (currDistance > current.second->distance + cost(current.second->ID, adj_vertex.first)) {
-                    currDistance = current.second->distance + cost(current.second->ID, adj_vertex.first); // update current distance
-                    graph.at(adj_vertex.first)->distance = currDistance; // update vertex distance
-                    q.push(std::pair<double, Vertex*>(cost(current.second->ID, adj_vertex.first), graph.at(adj_vertex.first))); // enqueue since distance changed
-                    graph.at(adj_vertex.first)->predecessor = current.second; // update predecessor
+    // early exit variants - stop once every target is settled or the frontier passes max_distance
+    template <class Queue = DefaultQueue>
+    ShortestPaths shortest_paths(VertexId src, const std::vector<VertexId>& targets, double max_distance = INFINITY) const {
+        ShortestPaths result;
+        shortest_paths<Queue>(src, targets, max_distance, result);
+        return result;
+    }
+
+    template <class Queue = DefaultQueue>
+    void shortest_paths(VertexId src, const std::vector<VertexId>& targets, double max_distance, ShortestPaths& result) const {
+        /*
+         *  only vertices settled before the search stopped are reported, everything else reads as unreachable
+         *  an empty target list means "all vertices", so only max_distance limits the search
+        */
+        search<Queue>(&src, nullptr, 1, targets.data(), targets.size(), max_distance, result);
+    }
+
+    template <class Queue = DefaultQueue>
+    std::vector<VertexId> shortest_path(VertexId src, VertexId dest) const {
+        // vertex IDs from src to dest inclusive, empty when dest is unreachable
+        ShortestPaths& result = scratch().paths;
+        search<Queue>(&src, nullptr, 1, &dest, 1, INFINITY, result);
+        return result.path(dest);
+    }
+
+    template <class Queue = DefaultQueue>
+    Path bidirectional_shortest_path(VertexId src, VertexId dest) const {
+        /*
+         *  searches forward from src over adj_list and backward from dest over in_list, alternating one
+         *  settled vertex at a time, and stops once the two frontiers can no longer improve the best meeting
+        */
+        require_non_negative();
+        SearchRecorder recorder("bidirectional_dijkstra", src);
+        Path best;
+        if (!contains_vertex(src) || !contains_vertex(dest)) return best;
+
+        Scratch& buffers = scratch();
+        ShortestPaths& forward = buffers.paths;
+        ShortestPaths& backward = buffers.reverse; // predecessors here point towards dest
+        Queue& forward_queue = scratch_queue<Queue, 0>();
+        Queue& backward_queue = scratch_queue<Queue, 1>();
+        forward.reset(this, src);
+        backward.reset(this, dest);
+        forward_queue.clear(slots.size());
+        backward_queue.clear(slots.size());
+
+        size_t source = vertex_at(src)->index;
+        size_t target = vertex_at(dest)->index;
+        forward.label(source, 0, npos);
+        backward.label(target, 0, npos);
+        forward_queue.push(source, 0);
+        recorder.push(forward_queue.size());
+        backward_queue.push(target, 0);
+        recorder.push(forward_queue.size() + backward_queue.size());
+        recorder.phase("setup");
+
+        // best meeting edge tail -> head, tail reached from src and head from dest (tail == head when src == dest)
+        double mu = source == target ? 0 : INFINITY;
+        size_t tail = source, head = target;
+        double forward_radius = 0, backward_radius = 0; // distance of the last vertex settled on each side
+        bool forward_turn = true;
+
+        while (!forward_queue.empty() && !backward_queue.empty()) {
+            bool is_forward = forward_turn;
+            forward_turn = !forward_turn;
+            Queue& queue = is_forward ? forward_queue : backward_queue;
+            ShortestPaths& mine = is_forward ? forward : backward;
+            ShortestPaths& other = is_forward ? backward : forward;
+
+            std::pair<double, size_t> current = queue.pop();
+            if (mine.settled(current.second) || current.first > mine.distances[current.second]) { // stale entry
+                recorder.stale();
+                continue;
+            }
+
+            (is_forward ? forward_radius : backward_radius) = current.first;
+            if (forward_radius + backward_radius >= mu) break; // no unsettled vertex can lie on a shorter route
+            mine.stamps[current.second] = 2 * mine.epoch + 1;
+            recorder.settle();
+
+            const EdgeMap& incident = is_forward ? slots[current.second]->adj_list : slots[current.second]->in_list;
+            for (const Adjacent& adj_vertex : incident) {
+                recorder.relax();
+                size_t next = vertex_at(adj_vertex.first)->index;
+                double candidate = current.first + adj_vertex.second;
+                if (!mine.settled(next) && (!mine.labeled(next) || candidate < mine.distances[next])) {
+                    mine.label(next, candidate, current.second);
+                    queue.push(next, candidate);
+                    recorder.push(forward_queue.size() + backward_queue.size());
+                }
+
+                // the edge joins both searches
+                if (other.labeled(next) && candidate + other.distances[next] < mu) {
+                    mu = candidate + other.distances[next];
+                    tail = is_forward ? current.second : next;
+                    head = is_forward ? next : current.second;
+                }
+            }
+        }
+
+        recorder.phase("search");
+        if (mu == INFINITY) return best;
+
+        best.distance = mu;
+        for (size_t slot = tail; slot != npos; slot = forward.predecessors[slot]) {
+            best.vertices.push_back(slots[slot]->ID);
+        }
+        std::reverse(best.vertices.begin(), best.vertices.end());
+        if (head != tail) {
+            for (size_t slot = head; slot != npos; slot = backward.predecessors[slot]) {
+                best.vertices.push_back(slots[slot]->ID);
+            }
+        }
+        recorder.phase("path");
+        return best;
+    }
+
+    template <class Queue = BinaryHeap, class Heuristic>
+    Path astar(VertexId src, VertexId dest, Heuristic heuristic) const {
+        /*
+         *  heuristic(id) must never overestimate the distance from id to dest - it is a template parameter so
+         *  lambdas and the built-in heuristics inline into the loop. An admissible but inconsistent heuristic
+         *  still gives exact answers because improved vertices are reopened. With RadixHeap the heuristic must
+         *  also be consistent, since the queue keys have to be monotone.
+        */
+        require_non_negative();
+        SearchRecorder recorder("astar", src);
+        Path best;
+        if (!contains_vertex(src) || !contains_vertex(dest)) return best;
+
+        ShortestPaths& result = scratch().paths;
+        Queue& queue = scratch_queue<Queue>();
+        result.reset(this, src);
+        queue.clear(slots.size());
+
+        size_t source = vertex_at(src)->index;
+        size_t target = vertex_at(dest)->index;
+        result.label(source, 0, npos);
+        queue.push(source, heuristic(src));
+        recorder.push(queue.size());
+        recorder.phase("setup");
+
+        while (!queue.empty()) {
+            // grab the vertex with minimum distance + estimate
+            std::pair<double, size_t> current = queue.pop();
+            if (result.settled(current.second)) {
+                recorder.stale();
+                continue;
+            }
+
+            double known = result.distances[current.second];
+            if (current.first > known + heuristic(slots[current.second]->ID)) { // stale entry
+                recorder.stale();
+                continue;
+            }
+            result.stamps[current.second] = 2 * result.epoch + 1;
+            recorder.settle();
+
+            if (current.second == target) break;
+
+            for (const Adjacent& adj_vertex : slots[current.second]->adj_list) {
+                recorder.relax();
+                size_t next = vertex_at(adj_vertex.first)->index;
+                double candidate = known + adj_vertex.second;
+                if (!result.labeled(next) || candidate < result.distances[next]) {
+                    result.label(next, candidate, current.second); // reopens next if it was settled
+                    queue.push(next, candidate + heuristic(adj_vertex.first));
+                    recorder.push(queue.size());
+                }
+            }
+        }
+        recorder.phase("search");
+
+        if (!result.settled(target)) return best;
+        best.distance = result.distances[target];
+        best.vertices = result.path(dest);
+        recorder.phase("path");
+        return best;
+    }
+
+    template <class Queue = DefaultQueue>
+    std::vector<Path> k_shortest_paths(VertexId src, VertexId dest, size_t k) const {
+        /*
+         *  up to k loopless paths from src to dest in ascending order of distance (Yen's algorithm)
+         *  each spur search runs on this thread's scratch result and queue, banning the root path's vertices with an
+         *  epoch mark and the edges already taken from the spur vertex - the graph itself is never copied or changed
+         *  one backward search from dest up front gives every spur search an exact A* heuristic (bans only make paths
+         *  longer, so it stays admissible and consistent) and skips vertices that cannot reach dest at all
+        */
+        require_non_negative();
+        SearchRecorder recorder("k_shortest_paths", src);
+        std::vector<Path> paths;
+        if (k == 0 || !contains_vertex(src) || !contains_vertex(dest)) return paths;
+
+        struct Route {
+            std::vector<size_t> slots;
+            std::vector<double> prefix; // prefix[i] = distance from the source to slots[i]
+        };
+        Scratch& buffers = scratch();
+        ShortestPaths& result = buffers.paths;
+        ShortestPaths& to_target = buffers.reverse;
+        size_t source = vertex_at(src)->index, target = vertex_at(dest)->index;
+        backward_search<Queue>(target, to_target, recorder);
+        recorder.phase("setup");
+
+        std::vector<Route> found, candidates;
+        std::set<std::vector<size_t>> seen; // every route found or queued, to queue each only once
+        std::vector<size_t> cut; // next slots of the found routes sharing the current root
+        buffers.epoch++; // nothing banned
+        if (!spur_search<Queue>(source, target, cut, to_target, result, recorder)) return paths;
+        found.push_back(Route{std::vector<size_t>(), std::vector<double>()});
+        for (size_t slot = target; slot != npos; slot = result.predecessors[slot]) {
+            found.back().slots.push_back(slot);
+            found.back().prefix.push_back(result.distances[slot]);
+        }
+        std::reverse(found.back().slots.begin(), found.back().slots.end());
+        std::reverse(found.back().prefix.begin(), found.back().prefix.end());
+        seen.insert(found.back().slots);
+
+        while (found.size() < k) {
+            // deviate from the last route found at each of its vertices in turn
+            const Route& last = found.back();
+            for (size_t j = 0; j + 1 < last.slots.size(); j++) {
+                cut.clear();
+                for (const Route& route : found) {
+                    if (route.slots.size() > j + 1 && std::equal(last.slots.begin(), last.slots.begin() + static_cast<std::ptrdiff_t>(j + 1), route.slots.begin())) {
+                        cut.push_back(route.slots[j + 1]);
+                    }
+                }
+                buffers.epoch++;
+                if (buffers.marks.size() < slots.size()) buffers.marks.resize(slots.size(), 0);
+                for (size_t i = 0; i < j; i++) {
+                    buffers.marks[last.slots[i]] = buffers.epoch; // keeps the spur path off the root, so routes stay loopless
+                }
+
+                if (!spur_search<Queue>(last.slots[j], target, cut, to_target, result, recorder)) continue;
+                Route spur{std::vector<size_t>(last.slots.begin(), last.slots.begin() + static_cast<std::ptrdiff_t>(j)),
+                           std::vector<double>(last.prefix.begin(), last.prefix.begin() + static_cast<std::ptrdiff_t>(j))};
+                size_t root_end = spur.slots.size();
+                for (size_t slot = target; slot != npos; slot = result.predecessors[slot]) {
+                    spur.slots.push_back(slot);
+                    spur.prefix.push_back(last.prefix[j] + result.distances[slot]);
                 }
+                std::reverse(spur.slots.begin() + static_cast<std::ptrdiff_t>(root_end), spur.slots.end());
+                std::reverse(spur.prefix.begin() + static_cast<std::ptrdiff_t>(root_end), spur.prefix.end());
+                if (seen.insert(spur.slots).second) candidates.push_back(std::move(spur));
+            }
+            if (candidates.empty()) break;
+
+            // the shortest candidate is the next route - ties go to fewer vertices
+            size_t best = 0;
+            for (size_t c = 1; c < candidates.size(); c++) {
+                double d = candidates[c].prefix.back(), b = candidates[best].prefix.back();
+                if (d < b || (d == b && candidates[c].slots.size() < candidates[best].slots.size())) best = c;
+            }
+            found.push_back(std::move(candidates[best]));
+            candidates[best] = std::move(candidates.back());
+            candidates.pop_back();
+        }
+        recorder.phase("search");
+
+        for (const Route& route : found) {
+            paths.push_back(Path());
+            paths.back().distance = route.prefix.back();
+            for (size_t slot : route.slots) {
+                paths.back().vertices.push_back(slots[slot]->ID);
             }
         }
+        recorder.phase("path");
+        return paths;
+    }
+
+    template <class Queue = DefaultQueue>
+    void distance_matrix(const std::vector<VertexId>& sources, const std::vector<VertexId>& targets, double* out, size_t threads = 0) const {
+        /*
+         *  out[i * targets.size() + j] = distance from sources[i] to targets[j], INFINITY when unreachable
+         *  out must hold sources.size() * targets.size() doubles. One early-exit search per source, run on
+         *  up to threads threads (0 = all hardware threads) that each reuse their own search buffers
+        */
+        require_non_negative();
+        if (targets.empty()) return;
+
+        std::vector<size_t> columns(targets.size(), npos); // slot of every target
+        for (size_t j = 0; j < targets.size(); j++) {
+            if (contains_vertex(targets[j])) columns[j] = vertex_at(targets[j])->index;
+        }
+
+        parallel_for(sources.size(), threads, [this, &sources, &targets, &columns, out](size_t i) {
+            ShortestPaths& result = scratch().paths;
+            search<Queue>(&sources[i], nullptr, 1, targets.data(), targets.size(), INFINITY, result);
+
+            double* row = out + i * targets.size();
+            for (size_t j = 0; j < targets.size(); j++) {
+                row[j] = columns[j] != npos && result.settled(columns[j]) ? result.distances[columns[j]] : INFINITY;
+            }
+        });
+    }
+
+    /*
+     *  Bellman-Ford - shortest paths that may use negative edges, from one source or from several at once (as if a
+     *  virtual source had a zero weight edge to each). threads == 1 runs the queue based variant (SPFA); otherwise
+     *  every vertex pulls the best offer from its in-neighbours in synchronous rounds spread over threads threads
+     *  (0 = all hardware threads). Returns false when a negative cycle is reachable - result then reports nothing and
+     *  negative_cycle, if given, receives the cycle's vertex IDs in edge order
+    */
+    bool bellman_ford(VertexId src, ShortestPaths& result, std::vector<VertexId>* negative_cycle = nullptr, size_t threads = 1) const {
+        return bellman_ford(std::vector<VertexId>{src}, result, negative_cycle, threads);
+    }
+
+    bool bellman_ford(const std::vector<VertexId>& sources, ShortestPaths& result, std::vector<VertexId>* negative_cycle = nullptr,
+                      size_t threads = 1) const {
+        VertexId first = sources.empty() ? static_cast<VertexId>(npos) : sources[0];
+        SearchRecorder recorder("bellman_ford", first);
+        result.reset(this, first);
+        if (negative_cycle) negative_cycle->clear();
+
+        size_t n = slots.size();
+        std::fill_n(result.distances.begin(), n, INFINITY);
+        std::fill_n(result.predecessors.begin(), n, npos);
+        for (VertexId id : sources) {
+            Vertex* vertex = find_vertex(id);
+            if (vertex != nullptr) result.distances[vertex->index] = 0;
+        }
+        recorder.phase("setup");
+
+        size_t on_cycle = resolve_threads(threads) == 1 ? relax_queue(result, recorder) : relax_rounds(result, threads, recorder);
+        recorder.phase("relax");
+        if (on_cycle != npos) {
+            if (negative_cycle) {
+                size_t slot = on_cycle;
+                do {
+                    negative_cycle->push_back(slots[slot]->ID);
+                    slot = result.predecessors[slot];
+                } while (slot != on_cycle);
+                std::reverse(negative_cycle->begin(), negative_cycle->end());
+            }
+            return false;
+        }
+
+        for (size_t slot = 0; slot < n; slot++) {
+            if (result.distances[slot] != INFINITY) result.stamps[slot] = 2 * result.epoch + 1;
+        }
+        return true;
     }
 
     // helper for dijkstra
-    double distance(size_t id) const { 
+    double distance(VertexId id) const { 
         if (!contains_vertex(id)) return INFINITY;
-        else return graph.at(id)->distance;
+        else return vertex_at(id)->distance;
     }
 
     // visual representation
-    void print_shortest_path(size_t id, std::ostream& os = std::cout) const {
+    void print_shortest_path(VertexId id, std::ostream& os = std::cout) const {
         /*
          *  to be ran AFTER dijkstra has been called on any vertex
          *  prints the shortest path from the vertex passed to dijkstra to id
@@ -199,20 +1065,20 @@ class Graph {
         */
 
         // no path exists to a vertex which does not exist or one who has distance infinity after dijkstra has been ran
-        if (!contains_vertex(id) || graph.at(id)->distance == INFINITY) {
+        if (!contains_vertex(id) || vertex_at(id)->distance == INFINITY) {
             os << "<no path>" << std::endl;
             return;
         }
 
-        Vertex* tmpPred = graph.at(id); // starting vertex
-        std::stack<size_t> s; // to store path
+        Vertex* tmpPred = vertex_at(id); // starting vertex
+        std::stack<VertexId> s; // to store path
 
         while(tmpPred != nullptr) {
             s.push(tmpPred->ID);
             tmpPred = tmpPred->predecessor;
         }
         
-        size_t currID;
+        VertexId currID;
         while (!s.empty()) {
             currID = s.top();
             currID == id ? os << currID : os << currID << " --> ";
@@ -221,4 +1087,369 @@ class Graph {
 
         os << " distance: " << distance(id) << std::endl;
     }
+
+    private:
+    // vertex with the given ID, nullptr if there is none
+    Vertex* find_vertex(VertexId id) const {
+        if (mode == dense_ids) {
+            size_t position = static_cast<size_t>(id);
+            return position < by_id.size() ? by_id[position] : nullptr;
+        }
+        typename VertexMap::const_iterator it = graph.find(id);
+        return it == graph.end() ? nullptr : it->second;
+    }
+
+    // vertex with an ID known to exist - a plain vector load in dense mode, which is what the search loops rely on
+    Vertex* vertex_at(VertexId id) const {
+        return mode == dense_ids ? by_id[static_cast<size_t>(id)] : graph.at(id);
+    }
+
+    void unindex_vertex(VertexId id) {
+        if (mode == dense_ids) by_id[static_cast<size_t>(id)] = nullptr;
+        else graph.erase(id);
+    }
+
+    Vertex* create_vertex(VertexId id, size_t index) {
+        if (!arena) arena.reset(new Arena()); // moved from
+        Vertex* vertex = new (arena->allocate(sizeof(Vertex))) Vertex(id, index, arena.get());
+        if (degree_hint > 0) {
+            vertex->adj_list.reserve(degree_hint);
+            vertex->in_list.reserve(degree_hint);
+        }
+        return vertex;
+    }
+
+    // fill the hole in slots with the last vertex so slots stays dense
+    void release_slot(Vertex* vertex) {
+        Vertex* last = slots.back();
+        slots[vertex->index] = last;
+        last->index = vertex->index;
+        slots.pop_back();
+    }
+
+    static bool negative(Weight weight) {
+        if constexpr (std::is_unsigned<Weight>::value) return false;
+        else return weight < 0;
+    }
+
+    // Dijkstra and its variants settle vertices for good, which a negative edge could undercut later
+    void require_non_negative() const {
+        if (negative_edges > 0) throw std::domain_error("negative edge weights need bellman_ford or Johnson reweighting");
+    }
+
+    // empties a graph whose arena was moved away, leaving it usable
+    void forget() {
+        graph.clear();
+        by_id.clear();
+        slots.clear();
+        edges = 0;
+        negative_edges = 0;
+        mutations++;
+    }
+
+    void destroy_vertex(Vertex* vertex) {
+        vertex->~Vertex(); // returns its adjacency nodes to the arena free lists
+        arena->deallocate(vertex, sizeof(Vertex));
+    }
+
+    // per-thread buffers for the const queries, kept between calls to avoid reallocating
+    struct Scratch {
+        std::vector<size_t> marks; // marks[slot] == epoch for the targets of the current search
+        size_t epoch;
+        ShortestPaths paths;   // result storage for queries that only return a path
+        ShortestPaths reverse; // backward half of bidirectional_shortest_path
+
+        Scratch() : marks{}, epoch{0}, paths{}, reverse{} {}
+    };
+
+    static Scratch& scratch() {
+        static thread_local Scratch buffers;
+        return buffers;
+    }
+
+    template <class Queue, int Tag = 0>
+    static Queue& scratch_queue() {
+        static thread_local Queue queue;
+        return queue;
+    }
+
+    // full dijkstra towards target over the reverse index - result.distances[v] is then the distance from v to target
+    template <class Queue>
+    void backward_search(size_t target, ShortestPaths& result, SearchRecorder& recorder) const {
+        Queue& queue = scratch_queue<Queue>();
+        queue.clear(slots.size());
+        result.reset(this, slots[target]->ID);
+        result.label(target, 0, npos);
+        queue.push(target, 0);
+        recorder.push(queue.size());
+
+        while (!queue.empty()) {
+            std::pair<double, size_t> current = queue.pop();
+            if (result.settled(current.second) || current.first > result.distances[current.second]) { // stale entry
+                recorder.stale();
+                continue;
+            }
+            result.stamps[current.second] = 2 * result.epoch + 1;
+            recorder.settle();
+
+            for (const Adjacent& in_vertex : slots[current.second]->in_list) {
+                recorder.relax();
+                size_t next = vertex_at(in_vertex.first)->index;
+                double candidate = current.first + in_vertex.second;
+                if (!result.settled(next) && (!result.labeled(next) || candidate < result.distances[next])) {
+                    result.label(next, candidate, current.second);
+                    queue.push(next, candidate);
+                    recorder.push(queue.size());
+                }
+            }
+        }
+    }
+
+    // follows predecessors from start - a slot on a cycle of them, or npos when the walk ends at a source
+    // walked holds the number of the walk that last passed each slot, walk must be new
+    static size_t predecessor_cycle(const std::vector<size_t>& predecessors, size_t start, std::vector<size_t>& walked, size_t walk) {
+        size_t slot = start;
+        while (slot != npos && walked[slot] != walk) {
+            walked[slot] = walk;
+            slot = predecessors[slot];
+        }
+        return slot;
+    }
+
+    // SPFA - relaxes out of queued vertices until nothing improves; returns a slot on a negative cycle, or npos
+    size_t relax_queue(ShortestPaths& result, SearchRecorder& recorder) const {
+        size_t n = slots.size();
+        std::vector<double>& distances = result.distances;
+        std::vector<size_t>& predecessors = result.predecessors;
+        std::vector<size_t> hops(n, 0); // edges since the last cycle check, along the current predecessor chain
+        std::vector<size_t> walked(n, 0);
+        size_t walks = 0;
+        std::vector<bool> queued(n, false);
+        std::deque<size_t> fifo;
+        for (size_t slot = 0; slot < n; slot++) {
+            if (distances[slot] == INFINITY) continue;
+            queued[slot] = true;
+            fifo.push_back(slot);
+            recorder.push(fifo.size());
+        }
+
+        while (!fifo.empty()) {
+            size_t current = fifo.front();
+            fifo.pop_front();
+            queued[current] = false;
+            recorder.settle();
+
+            for (const Adjacent& adj_vertex : slots[current]->adj_list) {
+                recorder.relax();
+                size_t next = vertex_at(adj_vertex.first)->index;
+                double candidate = distances[current] + adj_vertex.second;
+                if (candidate >= distances[next]) continue;
+                distances[next] = candidate;
+                predecessors[next] = current;
+
+                // a chain of n edges repeats a vertex - look for the cycle, and only every n edges so checks stay cheap
+                hops[next] = hops[current] + 1;
+                if (hops[next] >= n) {
+                    size_t on_cycle = predecessor_cycle(predecessors, next, walked, ++walks);
+                    if (on_cycle != npos) return on_cycle;
+                    hops[next] = 0;
+                }
+                if (!queued[next]) {
+                    queued[next] = true;
+                    fifo.push_back(next);
+                    recorder.push(fifo.size());
+                }
+            }
+        }
+        return npos;
+    }
+
+    // synchronous Bellman-Ford rounds - a vertex can only improve after one of its in-neighbours did, so each round
+    // takes the out-neighbours of last round's improved vertices and has each read the previous distances of its
+    // in-neighbours; every vertex writes only its own entry, so that part splits over threads without locking
+    // returns a slot on a negative cycle, or npos
+    size_t relax_rounds(ShortestPaths& result, size_t threads, SearchRecorder& recorder) const {
+        static constexpr size_t block = 1024; // candidates per work item
+
+        size_t n = slots.size();
+        std::vector<double>& distances = result.distances;
+        std::vector<size_t>& predecessors = result.predecessors;
+        std::vector<size_t> improved;   // slots improved by the last round
+        std::vector<size_t> candidates; // their out-neighbours, each once
+        std::vector<double> offers;     // per candidate - best distance through an in-neighbour
+        std::vector<size_t> from;       // per candidate - that in-neighbour, npos for no improvement
+        std::vector<size_t> round_of(n, 0); // last round a slot became a candidate
+        std::vector<size_t> walked(n, 0);
+        size_t walks = 0;
+        for (size_t slot = 0; slot < n; slot++) {
+            if (distances[slot] != INFINITY) improved.push_back(slot);
+        }
+
+        for (size_t round = 1; !improved.empty(); round++) {
+            candidates.clear();
+            for (size_t slot : improved) {
+                for (const Adjacent& adj_vertex : slots[slot]->adj_list) {
+                    size_t next = vertex_at(adj_vertex.first)->index;
+                    if (round_of[next] == round) continue;
+                    round_of[next] = round;
+                    candidates.push_back(next);
+                }
+            }
+            offers.resize(candidates.size());
+            from.resize(candidates.size());
+
+            size_t blocks = (candidates.size() + block - 1) / block;
+            parallel_for(blocks, threads, [this, &distances, &candidates, &offers, &from](size_t b) {
+                for (size_t i = b * block; i < std::min(candidates.size(), (b + 1) * block); i++) {
+                    size_t slot = candidates[i];
+                    offers[i] = distances[slot];
+                    from[i] = npos;
+                    for (const Adjacent& in_vertex : slots[slot]->in_list) {
+                        size_t prior = vertex_at(in_vertex.first)->index;
+                        if (distances[prior] + in_vertex.second < offers[i]) {
+                            offers[i] = distances[prior] + in_vertex.second;
+                            from[i] = prior;
+                        }
+                    }
+                }
+            });
+
+            improved.clear();
+            for (size_t i = 0; i < candidates.size(); i++) {
+                recorder.relax(slots[candidates[i]]->in_list.size());
+                if (from[i] == npos) continue;
+                distances[candidates[i]] = offers[i];
+                predecessors[candidates[i]] = from[i];
+                improved.push_back(candidates[i]);
+            }
+            recorder.settle(candidates.size());
+
+            // still improving after n rounds means a walk of more than n edges - a negative cycle, possibly not yet
+            // closed in the predecessors, so keep going until it is
+            if (round >= n && !improved.empty()) {
+                size_t on_cycle = predecessor_cycle(predecessors, improved.front(), walked, ++walks);
+                if (on_cycle != npos) return on_cycle;
+            }
+        }
+        return npos;
+    }
+
+    // A* from spur to target guided by the exact distances of to_target, skipping vertices marked in scratch() with its
+    // current epoch and the edges from spur to any slot in cut - a spur search of k_shortest_paths
+    template <class Queue>
+    bool spur_search(size_t spur, size_t target, const std::vector<size_t>& cut, const ShortestPaths& to_target, ShortestPaths& result,
+                     SearchRecorder& recorder) const {
+        Scratch& buffers = scratch();
+        Queue& queue = scratch_queue<Queue>();
+        queue.clear(slots.size());
+        result.reset(this, slots[spur]->ID);
+        if (!to_target.settled(spur)) return false;
+        result.label(spur, 0, npos);
+        queue.push(spur, to_target.distances[spur]);
+        recorder.push(queue.size());
+
+        while (!queue.empty()) {
+            // a consistent heuristic settles every vertex on its first pop
+            std::pair<double, size_t> current = queue.pop();
+            if (result.settled(current.second)) {
+                recorder.stale();
+                continue;
+            }
+            result.stamps[current.second] = 2 * result.epoch + 1;
+            recorder.settle();
+            if (current.second == target) return true;
+
+            double known = result.distances[current.second];
+            for (const Adjacent& adj_vertex : slots[current.second]->adj_list) {
+                recorder.relax();
+                size_t next = vertex_at(adj_vertex.first)->index;
+                if (!to_target.settled(next) || result.settled(next)) continue; // dead end, or done
+                if (next < buffers.marks.size() && buffers.marks[next] == buffers.epoch) continue; // on the root path
+                if (current.second == spur && std::find(cut.begin(), cut.end(), next) != cut.end()) continue;
+                double candidate = known + adj_vertex.second;
+                if (!result.labeled(next) || candidate < result.distances[next]) {
+                    result.label(next, candidate, current.second);
+                    // keys never drop below the last pop, so rounding in the heuristic cannot upset a monotone queue
+                    queue.push(next, std::max(current.first, candidate + to_target.distances[next]));
+                    recorder.push(queue.size());
+                }
+            }
+        }
+        return false;
+    }
+
+    template <class Queue>
+    void search(const VertexId* sources, const double* offsets, size_t source_count, const VertexId* targets, size_t target_count,
+                double max_distance, ShortestPaths& result, bool track_origins = false) const {
+        VertexId first = source_count > 0 ? sources[0] : static_cast<VertexId>(npos);
+        require_non_negative();
+        SearchRecorder recorder(track_origins ? "multi_source_dijkstra" : "dijkstra", first);
+        result.reset(this, first, track_origins);
+
+        Scratch& buffers = scratch();
+        Queue& queue = scratch_queue<Queue>();
+        queue.clear(slots.size());
+
+        // mark the distinct existing targets so settling one is an O(1) check
+        size_t remaining = 0;
+        if (target_count > 0) {
+            buffers.epoch++;
+            if (buffers.marks.size() < slots.size()) buffers.marks.resize(slots.size(), 0);
+            for (size_t t = 0; t < target_count; t++) {
+                if (!contains_vertex(targets[t])) continue;
+                size_t slot = vertex_at(targets[t])->index;
+                if (buffers.marks[slot] == buffers.epoch) continue;
+                buffers.marks[slot] = buffers.epoch;
+                remaining++;
+            }
+            if (remaining == 0) return; // nothing reachable was asked for
+        }
+
+        // seed the queue - a source listed twice keeps its smaller offset
+        for (size_t i = 0; i < source_count; i++) {
+            Vertex* vertex = find_vertex(sources[i]);
+            double offset = offsets ? offsets[i] + 0.0 : 0; // + 0.0 turns -0.0 into 0, whose bits RadixHeap can order
+            if (vertex == nullptr || offset == INFINITY || offset > max_distance) continue;
+            size_t source = vertex->index;
+            if (result.labeled(source) && result.distances[source] <= offset) continue;
+            result.label(source, offset, npos);
+            if (track_origins) result.origins[source] = source;
+            queue.push(source, offset);
+            recorder.push(queue.size());
+        }
+        recorder.phase("setup");
+
+        while (!queue.empty()) {
+            // grab the unsettled vertex with minimum distance
+            std::pair<double, size_t> current = queue.pop();
+
+            if (result.settled(current.second) || current.first > result.distances[current.second]) { // stale entry
+                recorder.stale();
+                continue;
+            }
+            if (current.first > max_distance) break; // frontier passed the bound
+            result.stamps[current.second] = 2 * result.epoch + 1; // shortest path is known
+            recorder.settle();
+
+            if (target_count > 0 && buffers.marks[current.second] == buffers.epoch && --remaining == 0) break;
+
+            // update the distance for all vertices adjacent to current
+            for (const Adjacent& adj_vertex : slots[current.second]->adj_list) {
+                recorder.relax();
+                size_t next = vertex_at(adj_vertex.first)->index;
+                double candidate = current.first + adj_vertex.second;
+                if (candidate > max_distance) continue; // never settled anyway
+                if (result.settled(next)) continue;
+                if (!result.labeled(next) || candidate < result.distances[next]) {
+                    result.label(next, candidate, current.second);
+                    if (track_origins) result.origins[next] = result.origins[current.second];
+                    queue.push(next, candidate);
+                    recorder.push(queue.size());
+                }
+            }
+        }
+        recorder.phase("search");
+    }
 };
+
+typedef BasicGraph<> Graph;
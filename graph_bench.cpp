@@ -0,0 +1,206 @@
+#include "graph.h"
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath> // sqrt
+#include <unistd.h> // sysconf
+
+// end to end benchmark over synthetic graphs - `make bench`, or `make bench BENCH_MAX=10000000` for the 1e7 graphs
+// usage: ./graph_bench [max_vertices] - sizes run from 1e3 up to max_vertices (default 1e6) in powers of ten
+// prints one CSV row per measurement: graph,vertices,edges,metric,value
+
+typedef std::chrono::steady_clock Clock;
+
+double milliseconds(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// resident set size from /proc, 0 where that is not available
+double resident_mb() {
+    std::ifstream statm("/proc/self/statm");
+    size_t total = 0, resident = 0;
+    if (!(statm >> total >> resident)) return 0;
+    return static_cast<double>(resident) * static_cast<double>(sysconf(_SC_PAGESIZE)) / (1024.0 * 1024.0);
+}
+
+// G(n, m) - m edges between uniformly random vertices
+std::vector<Graph::Edge> random_edges(size_t n, size_t m, std::mt19937_64& rng) {
+    std::uniform_int_distribution<size_t> vertex(0, n - 1);
+    std::uniform_real_distribution<double> weight(1, 100);
+    std::vector<Graph::Edge> edges(m);
+    for (Graph::Edge& edge : edges) {
+        edge = Graph::Edge{vertex(rng), vertex(rng), weight(rng)};
+    }
+    return edges;
+}
+
+// 4-neighbour grid with edges in both directions
+std::vector<Graph::Edge> grid_edges(size_t n, std::mt19937_64& rng) {
+    size_t side = static_cast<size_t>(std::sqrt(static_cast<double>(n)));
+    std::uniform_real_distribution<double> weight(1, 100);
+    std::vector<Graph::Edge> edges;
+    edges.reserve(4 * side * side);
+    for (size_t r = 0; r < side; r++) {
+        for (size_t c = 0; c < side; c++) {
+            size_t v = r * side + c;
+            double w = weight(rng);
+            if (c + 1 < side) { edges.push_back(Graph::Edge{v, v + 1, w}); edges.push_back(Graph::Edge{v + 1, v, w}); }
+            w = weight(rng);
+            if (r + 1 < side) { edges.push_back(Graph::Edge{v, v + side, w}); edges.push_back(Graph::Edge{v + side, v, w}); }
+        }
+    }
+    return edges;
+}
+
+// preferential attachment (Barabasi-Albert) - each new vertex links both ways to k vertices picked by degree
+std::vector<Graph::Edge> power_law_edges(size_t n, size_t k, std::mt19937_64& rng) {
+    std::uniform_real_distribution<double> weight(1, 100);
+    std::vector<size_t> endpoints; // every vertex once per incident edge, so a uniform pick is degree biased
+    std::vector<Graph::Edge> edges;
+    edges.reserve(2 * n * k);
+    endpoints.reserve(2 * n * k);
+    for (size_t v = 0; v <= k && v < n; v++) {
+        endpoints.push_back(v);
+    }
+    for (size_t v = k + 1; v < n; v++) {
+        for (size_t j = 0; j < k; j++) {
+            size_t u = endpoints[std::uniform_int_distribution<size_t>(0, endpoints.size() - 1)(rng)];
+            double w = weight(rng);
+            edges.push_back(Graph::Edge{v, u, w});
+            edges.push_back(Graph::Edge{u, v, w});
+            endpoints.push_back(u);
+            endpoints.push_back(v);
+        }
+    }
+    return edges;
+}
+
+// road-like - a grid with 10% of its streets missing, weights proportional to length, every 16th row and column a fast arterial
+std::vector<Graph::Edge> road_edges(size_t n, std::mt19937_64& rng) {
+    size_t side = static_cast<size_t>(std::sqrt(static_cast<double>(n)));
+    std::uniform_real_distribution<double> length(80, 120);
+    std::bernoulli_distribution missing(0.1);
+    std::vector<Graph::Edge> edges;
+    edges.reserve(4 * side * side);
+    for (size_t r = 0; r < side; r++) {
+        for (size_t c = 0; c < side; c++) {
+            size_t v = r * side + c;
+            if (c + 1 < side && !missing(rng)) {
+                double w = length(rng) * (r % 16 == 0 ? 0.3 : 1.0);
+                edges.push_back(Graph::Edge{v, v + 1, w});
+                edges.push_back(Graph::Edge{v + 1, v, w});
+            }
+            if (r + 1 < side && !missing(rng)) {
+                double w = length(rng) * (c % 16 == 0 ? 0.3 : 1.0);
+                edges.push_back(Graph::Edge{v, v + side, w});
+                edges.push_back(Graph::Edge{v + side, v, w});
+            }
+        }
+    }
+    return edges;
+}
+
+struct Row {
+    std::string graph;
+    size_t vertices;
+    size_t edges;
+
+    void operator()(const std::string& metric, double value) const {
+        std::cout << graph << "," << vertices << "," << edges << "," << metric << "," << value << std::endl;
+    }
+};
+
+double percentile(std::vector<double>& samples, double p) {
+    std::sort(samples.begin(), samples.end());
+    size_t rank = static_cast<size_t>(p * static_cast<double>(samples.size() - 1) + 0.5);
+    return samples[rank];
+}
+
+void run(const std::string& name, size_t n, const std::vector<Graph::Edge>& edges, std::mt19937_64& rng) {
+    double rss_before = resident_mb();
+
+    // incremental construction, the path every caller without from_edges takes
+    Clock::time_point start = Clock::now();
+    Graph g;
+    for (size_t v = 0; v < n; v++) {
+        g.add_vertex(v);
+    }
+    Clock::time_point edges_start = Clock::now();
+    for (const Graph::Edge& edge : edges) {
+        g.add_edge(edge.src, edge.dest, edge.weight);
+    }
+    double edge_ms = milliseconds(edges_start);
+    double build_ms = milliseconds(start);
+    Row report{name, g.vertex_count(), g.edge_count()}; // sizes as built, removals below do not change the row key
+
+    report("build_ms", build_ms);
+    report("add_edge_per_sec", static_cast<double>(edges.size()) / (edge_ms / 1000.0));
+    report("arena_mb", static_cast<double>(g.arena_bytes()) / (1024.0 * 1024.0));
+    report("rss_growth_mb", resident_mb() - rss_before);
+
+    start = Clock::now();
+    Graph bulk = Graph::from_edges(edges);
+    report("from_edges_ms", milliseconds(start));
+    bulk.clear();
+
+    // the generated IDs are 0..n-1, so the same graph also fits the vector indexed mode
+    Graph dense = Graph::from_edges(edges, {}, Graph::dense_ids);
+
+    // single source latency, from random sources
+    size_t queries = n <= 100000 ? 100 : n <= 1000000 ? 20 : 5;
+    std::uniform_int_distribution<size_t> vertex(0, n - 1);
+    std::vector<size_t> sources(queries);
+    for (size_t& src : sources) {
+        src = vertex(rng);
+    }
+    Graph::ShortestPaths result;
+    double checksum = 0;
+    for (const Graph* searched : {&g, &dense}) {
+        std::vector<double> latencies;
+        for (size_t src : sources) {
+            start = Clock::now();
+            searched->shortest_paths(src, result);
+            latencies.push_back(milliseconds(start));
+            double d = result.distance(vertex(rng));
+            if (d != INFINITY) checksum += d; // keeps the work observable
+        }
+        std::string prefix = searched == &dense ? "dense_dijkstra" : "dijkstra";
+        report(prefix + "_p50_ms", percentile(latencies, 0.5));
+        report(prefix + "_p90_ms", percentile(latencies, 0.9));
+        report(prefix + "_p99_ms", percentile(latencies, 0.99));
+        report(prefix + "_max_ms", latencies.back());
+    }
+    report("checksum", checksum);
+    dense.clear();
+
+    // vertex removal, 1% of the vertices (at most 10k)
+    size_t removals = std::max<size_t>(1, std::min<size_t>(n / 100, 10000));
+    start = Clock::now();
+    size_t removed = 0;
+    for (size_t r = 0; r < removals; r++) {
+        removed += g.remove_vertex(vertex(rng));
+    }
+    report("remove_vertex_us", removed > 0 ? milliseconds(start) * 1000.0 / static_cast<double>(removed) : 0);
+
+    start = Clock::now();
+    g.clear();
+    report("teardown_ms", milliseconds(start));
+}
+
+int main(int argc, char** argv) {
+    size_t max_vertices = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+    std::cout << "graph,vertices,edges,metric,value" << std::endl;
+    for (size_t n = 1000; n <= max_vertices; n *= 10) {
+        std::mt19937_64 rng(42 + n);
+        run("gnm", n, random_edges(n, 4 * n, rng), rng);
+        run("grid", n, grid_edges(n, rng), rng);
+        run("power_law", n, power_law_edges(n, 4, rng), rng);
+        run("road", n, road_edges(n, rng), rng);
+    }
+    return 0;
+}
@@ -0,0 +1,284 @@
+/*
+*   Readers for common graph file formats, feeding Graph::from_edges
+*     edge list       - "src dest [weight]" per line, weight defaults to 1, lines starting with # or % are comments
+*     DIMACS .gr      - "p sp <vertices> <arcs>" then "a <src> <dest> <weight>", "c" lines are comments;
+*                       vertices 1..n all exist even without arcs
+*     Matrix Market   - coordinate format, real/integer/pattern, general/symmetric/skew-symmetric; entry (i, j)
+*                       is an edge i -> j, symmetric files get both directions, pattern entries weigh 1
+*   Input is scanned in large chunks and numbers are parsed with std::from_chars. Reading a path maps the file
+*   and parses line-aligned slices of it on several threads.
+*/
+
+#pragma once
+#include "graph.h"
+#include "mapped_file.h"
+#include "parallel.h"
+#include <vector>
+#include <string>
+#include <istream>
+#include <charconv> // from_chars
+#include <stdexcept> // runtime_error
+#include <algorithm> // find, max
+#include <cctype> // tolower
+
+class GraphReader {
+    public:
+    enum Format { edge_list, dimacs, matrix_market };
+
+    private:
+    static constexpr size_t chunk_size = 1 << 20;
+    static constexpr size_t min_slice = 1 << 20; // smaller inputs are not worth a thread
+
+    // what one slice of the input produced
+    struct Part {
+        std::vector<Graph::Edge> edges;
+        size_t vertices; // largest vertex count declared by a DIMACS problem line, 0 for none
+        std::string error;
+
+        Part() : edges{}, vertices{0}, error{} {}
+    };
+
+    Format format;
+    bool header_done; // Matrix Market banner and size line have been read - always true for the other formats
+    bool first_line;
+    bool symmetric;
+    bool skew;
+    bool pattern;
+    size_t declared;  // vertex count from the Matrix Market size line
+
+    public:
+    explicit GraphReader(Format format)
+        : format{format}, header_done{format != matrix_market}, first_line{true}, symmetric{false}, skew{false}, pattern{false}, declared{0} {}
+
+    // streaming read, one chunk at a time - throws runtime_error on malformed input
+    Graph read(std::istream& is) {
+        Part part;
+        std::vector<char> buffer(chunk_size);
+        size_t kept = 0; // bytes of an unfinished line carried over from the last chunk
+        while (is) {
+            if (kept == buffer.size()) buffer.resize(2 * buffer.size()); // a line longer than the buffer
+            is.read(buffer.data() + kept, static_cast<std::streamsize>(buffer.size() - kept));
+            size_t filled = kept + static_cast<size_t>(is.gcount());
+            const char* first = buffer.data();
+            const char* last = buffer.data() + filled;
+
+            // only whole lines are parsed until the input runs out
+            const char* end = last;
+            if (is) {
+                while (end > first && end[-1] != '\n') end--;
+            }
+            parse(first, end, part);
+            if (!part.error.empty()) throw std::runtime_error(part.error);
+
+            kept = static_cast<size_t>(last - end);
+            if (end != first) std::copy(end, last, buffer.begin());
+        }
+        std::vector<Part> parts;
+        parts.push_back(std::move(part));
+        return finish(std::move(parts));
+    }
+
+    Graph read(const std::string& path, size_t threads = 0) {
+        /*
+         *  maps the file, reads any header on the calling thread and splits the rest at line boundaries into
+         *  one slice per thread; threads == 0 uses every hardware thread
+        */
+        MappedFile file(path);
+        const char* first = file.data();
+        const char* last = file.data() + file.size();
+
+        Part head;
+        while (!header_done && first < last) {
+            const char* end = std::find(first, last, '\n');
+            line(first, end, head);
+            if (!head.error.empty()) throw std::runtime_error(head.error);
+            first = end < last ? end + 1 : last;
+        }
+
+        size_t slices = std::max<size_t>(1, std::min(resolve_threads(threads), static_cast<size_t>(last - first) / min_slice));
+        std::vector<const char*> bounds(slices + 1, last);
+        bounds[0] = first;
+        for (size_t s = 1; s < slices; s++) {
+            const char* cut = std::max(bounds[s - 1], first + (last - first) / static_cast<std::ptrdiff_t>(slices) * static_cast<std::ptrdiff_t>(s));
+            const char* newline = std::find(cut, last, '\n');
+            bounds[s] = newline < last ? newline + 1 : last;
+        }
+
+        std::vector<Part> parts(slices + 1);
+        parts[0] = std::move(head);
+        parallel_for(slices, threads, [this, &bounds, &parts](size_t s) {
+            parse(bounds[s], bounds[s + 1], parts[s + 1]);
+        });
+        for (const Part& part : parts) {
+            if (!part.error.empty()) throw std::runtime_error(part.error);
+        }
+        return finish(std::move(parts));
+    }
+
+    private:
+    // every line in [first, last) - errors are recorded in the part, since slices run on worker threads
+    void parse(const char* first, const char* last, Part& part) {
+        while (first < last && part.error.empty()) {
+            const char* end = std::find(first, last, '\n');
+            line(first, end, part);
+            first = end < last ? end + 1 : last;
+        }
+    }
+
+    void line(const char* first, const char* last, Part& part) {
+        if (last > first && last[-1] == '\r') last--;
+        if (!header_done) {
+            header(first, last, part);
+            return;
+        }
+
+        const char* p = skip_space(first, last);
+        if (p == last) return; // blank line
+        if (*p == '#' || *p == '%') return;
+
+        size_t src, dest;
+        double weight = 1.0;
+        if (format == dimacs) {
+            if (*p == 'c') return;
+            if (*p == 'p') {
+                size_t vertices, arcs;
+                p = skip_space(p + 1, last);
+                if (last - p < 2 || p[0] != 's' || p[1] != 'p' ||
+                    !parse_number(p += 2, last, vertices) || !parse_number(p, last, arcs) || skip_space(p, last) != last) {
+                    malformed(first, last, part);
+                    return;
+                }
+                part.vertices = std::max(part.vertices, vertices);
+                return;
+            }
+            if (*p != 'a' || !parse_number(++p, last, src) || !parse_number(p, last, dest) || !parse_number(p, last, weight)) {
+                malformed(first, last, part);
+                return;
+            }
+        } else {
+            if (!parse_number(p, last, src) || !parse_number(p, last, dest)) {
+                malformed(first, last, part);
+                return;
+            }
+            // the weight is optional in edge lists, required by real and integer Matrix Market files, absent in pattern ones
+            bool more = skip_space(p, last) != last;
+            bool weighted = format == edge_list ? more : !pattern;
+            if (weighted && !parse_number(p, last, weight)) {
+                malformed(first, last, part);
+                return;
+            }
+        }
+        if (skip_space(p, last) != last) {
+            malformed(first, last, part);
+            return;
+        }
+
+        part.edges.push_back(Graph::Edge{src, dest, weight});
+        if (format == matrix_market && src != dest && (symmetric || skew)) {
+            part.edges.push_back(Graph::Edge{dest, src, skew ? -weight : weight});
+        }
+    }
+
+    // Matrix Market banner, comments and size line
+    void header(const char* first, const char* last, Part& part) {
+        std::string text(first, last);
+        if (first_line) {
+            first_line = false;
+            std::vector<std::string> words = split(text);
+            for (std::string& word : words) {
+                for (char& c : word) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+            }
+            if (words.size() != 5 || words[0] != "%%matrixmarket" || words[1] != "matrix" || words[2] != "coordinate") {
+                part.error = "GraphReader: not a Matrix Market coordinate file";
+                return;
+            }
+            if (words[3] != "real" && words[3] != "integer" && words[3] != "pattern") {
+                part.error = "GraphReader: unsupported Matrix Market field " + words[3];
+                return;
+            }
+            if (words[4] != "general" && words[4] != "symmetric" && words[4] != "skew-symmetric") {
+                part.error = "GraphReader: unsupported Matrix Market symmetry " + words[4];
+                return;
+            }
+            pattern = words[3] == "pattern";
+            symmetric = words[4] == "symmetric";
+            skew = words[4] == "skew-symmetric";
+            return;
+        }
+
+        const char* p = skip_space(first, last);
+        if (p == last || *p == '%') return;
+        size_t rows, columns, entries;
+        if (!parse_number(p, last, rows) || !parse_number(p, last, columns) || !parse_number(p, last, entries) || skip_space(p, last) != last) {
+            malformed(first, last, part);
+            return;
+        }
+        declared = std::max(rows, columns);
+        header_done = true;
+    }
+
+    Graph finish(std::vector<Part> parts) {
+        size_t total = 0, vertices = declared;
+        for (const Part& part : parts) {
+            total += part.edges.size();
+            vertices = std::max(vertices, part.vertices);
+        }
+        if (!header_done) throw std::runtime_error("GraphReader: missing Matrix Market size line");
+
+        std::vector<Graph::Edge> edges;
+        edges.reserve(total);
+        for (Part& part : parts) {
+            edges.insert(edges.end(), part.edges.begin(), part.edges.end());
+            std::vector<Graph::Edge>().swap(part.edges);
+        }
+
+        // DIMACS and Matrix Market number vertices from 1 and declare how many there are
+        std::vector<size_t> ids(vertices);
+        for (size_t v = 0; v < vertices; v++) {
+            ids[v] = v + 1;
+        }
+        return Graph::from_edges(std::move(edges), ids);
+    }
+
+    static const char* skip_space(const char* p, const char* last) {
+        while (p < last && (*p == ' ' || *p == '\t')) p++;
+        return p;
+    }
+
+    // parses one whitespace separated number at p and moves p past it
+    template <class T>
+    static bool parse_number(const char*& p, const char* last, T& value) {
+        p = skip_space(p, last);
+        std::from_chars_result result = std::from_chars(p, last, value);
+        if (result.ec != std::errc() || (result.ptr < last && *result.ptr != ' ' && *result.ptr != '\t')) return false;
+        p = result.ptr;
+        return true;
+    }
+
+    static void malformed(const char* first, const char* last, Part& part) {
+        if (part.error.empty()) part.error = "GraphReader: malformed line \"" + std::string(first, last) + "\"";
+    }
+
+    static std::vector<std::string> split(const std::string& text) {
+        std::vector<std::string> words;
+        std::string word;
+        for (char c : text) {
+            if (c == ' ' || c == '\t') {
+                if (!word.empty()) words.push_back(word);
+                word.clear();
+            } else {
+                word += c;
+            }
+        }
+        if (!word.empty()) words.push_back(word);
+        return words;
+    }
+};
+
+// convenience wrappers
+inline Graph read_edge_list(std::istream& is) { return GraphReader(GraphReader::edge_list).read(is); }
+inline Graph read_edge_list(const std::string& path, size_t threads = 0) { return GraphReader(GraphReader::edge_list).read(path, threads); }
+inline Graph read_dimacs(std::istream& is) { return GraphReader(GraphReader::dimacs).read(is); }
+inline Graph read_dimacs(const std::string& path, size_t threads = 0) { return GraphReader(GraphReader::dimacs).read(path, threads); }
+inline Graph read_matrix_market(std::istream& is) { return GraphReader(GraphReader::matrix_market).read(is); }
+inline Graph read_matrix_market(const std::string& path, size_t threads = 0) { return GraphReader(GraphReader::matrix_market).read(path, threads); }
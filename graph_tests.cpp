@@ -1,5 +1,19 @@
 #include "graph.h"
+#include "contraction_hierarchy.h"
+#include "delta_stepping.h"
+#include "graph_io.h"
+#include "dynamic_shortest_paths.h"
+#include "path_cache.h"
+#include "shared_graph.h"
+#include "reorder.h"
+#include "johnson.h"
 #include <iostream>
+#include <thread>
+#include <vector>
+#include <random>
+#include <sstream>
+#include <fstream>
+#include <cstdio> // remove
 
 using std::cout, std::endl;
 
@@ -509,6 +523,1767 @@ void internal_dijkstra() {
 */
 
 
+void compact_graph() {
+  std::cout << std::endl << "begin compact_graph" << std::endl;
+  Graph G;
+  for (size_t n = 1; n <= 7; n++) {
+    G.add_vertex(n * 10); // sparse IDs to exercise the ID remapping
+  }
+  G.add_edge(10,20,2);
+  G.add_edge(10,40,1);
+  G.add_edge(20,40,3);
+  G.add_edge(20,50,10);
+  G.add_edge(30,10,4);
+  G.add_edge(30,60,5);
+  G.add_edge(40,30,2);
+  G.add_edge(40,60,8);
+  G.add_edge(40,70,4);
+  G.add_edge(40,50,2);
+  G.add_edge(50,70,6);
+  G.add_edge(70,60,1);
+
+  CompactGraph C = G.freeze();
+  expect(C.vertex_count() to_be 7);
+  expect(C.edge_count() to_be 12);
+  expect(C.contains_vertex(10) to_be true);
+  expect(C.contains_vertex(1) to_be false);
+  expect(C.index_of(10) to_be 0);
+  expect(C.index_of(70) to_be 6);
+  expect(C.index_of(75) to_be CompactGraph::npos);
+  expect(C.id_of(3) to_be 40);
+  expect(C.degree(C.index_of(40)) to_be 4);
+  expect(C.contains_edge(40, 50) to_be true);
+  expect(C.contains_edge(50, 40) to_be false);
+  expect(C.contains_edge(40, 99) to_be false);
+  expect(C.cost(20, 50) to_be 10.0);
+  expect(C.cost(50, 20) to_be INFINITY);
+
+  // snapshot is independent of later changes to the graph
+  G.remove_vertex(40);
+  expect(C.contains_edge(40, 50) to_be true);
+
+  C.dijkstra(20);
+  expect(C.distance(10) to_be 9);
+  expect(C.distance(20) to_be 0);
+  expect(C.distance(30) to_be 5);
+  expect(C.distance(40) to_be 3);
+  expect(C.distance(50) to_be 5);
+  expect(C.distance(60) to_be 8);
+  expect(C.distance(70) to_be 7);
+  expect(C.distance(99) to_be INFINITY);
+  C.print_shortest_path(60);
+
+  C.dijkstra(60); // no outgoing edges
+  expect(C.distance(60) to_be 0);
+  expect(C.distance(10) to_be INFINITY);
+  C.print_shortest_path(10);
+
+  // empty snapshot
+  CompactGraph E = Graph().freeze();
+  expect(E.vertex_count() to_be 0);
+  expect(E.edge_count() to_be 0);
+  E.dijkstra(1);
+  expect(E.distance(1) to_be INFINITY);
+
+  std::cout << "end compact_graph" << std::endl;
+}
+
+void const_shortest_paths() {
+  std::cout << std::endl << "begin const_shortest_paths" << std::endl;
+  Graph G;
+  for (size_t n = 1; n <= 7; n++) {
+    G.add_vertex(n);
+  }
+  G.add_edge(1,2,2);
+  G.add_edge(1,4,1);
+  G.add_edge(2,4,3);
+  G.add_edge(2,5,10);
+  G.add_edge(3,1,4);
+  G.add_edge(3,6,5);
+  G.add_edge(4,3,2);
+  G.add_edge(4,6,8);
+  G.add_edge(4,7,4);
+  G.add_edge(4,5,2);
+  G.add_edge(5,7,6);
+  G.add_edge(7,6,1);
+
+  const Graph& C = G;
+  Graph::ShortestPaths from2 = C.shortest_paths(2);
+  Graph::ShortestPaths from1 = C.shortest_paths(1);
+  expect(from2.source() to_be 2);
+  expect(from2.distance(1) to_be 9);
+  expect(from2.distance(2) to_be 0);
+  expect(from2.distance(6) to_be 8);
+  expect(from1.distance(6) to_be 6);
+  expect(from1.distance(3) to_be 3);
+  expect(from2.predecessor(2) to_be Graph::npos);
+  expect(from2.predecessor(6) to_be 7);
+  expect(from2.path(6) to_be (std::vector<size_t>{2, 4, 7, 6}));
+  expect(from1.path(1) to_be (std::vector<size_t>{1}));
+  expect(from1.reachable(9) to_be false);
+  expect(from1.path(9).empty() to_be true);
+
+  // reusing a result object
+  Graph::ShortestPaths reused;
+  expect(reused.distance(1) to_be INFINITY);
+  C.shortest_paths(6, reused);
+  expect(reused.distance(6) to_be 0);
+  expect(reused.reachable(1) to_be false);
+  C.shortest_paths(42, reused); // source does not exist
+  expect(reused.reachable(42) to_be false);
+  expect(reused.reachable(1) to_be false);
+
+  // the legacy interface still works and agrees
+  G.dijkstra(2);
+  for (size_t n = 1; n <= 7; n++) {
+    expect(G.distance(n) to_be from2.distance(n));
+  }
+
+  // many threads querying the same const graph at once
+  std::vector<std::thread> threads;
+  std::vector<int> mismatches(4, 0);
+  for (size_t t = 0; t < mismatches.size(); t++) {
+    threads.emplace_back([&C, &mismatches, t]() {
+      Graph::ShortestPaths result;
+      for (size_t round = 0; round < 200; round++) {
+        size_t src = 1 + (round + t) % 7;
+        C.shortest_paths(src, result);
+        if (result.distance(src) != 0) mismatches[t]++;
+        if (src == 2 && result.distance(6) != 8) mismatches[t]++;
+        if (src == 1 && result.distance(7) != 5) mismatches[t]++;
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  for (int mismatch : mismatches) {
+    expect(mismatch to_be 0);
+  }
+
+  // removing vertices keeps queries consistent
+  G.remove_vertex(4);
+  Graph::ShortestPaths after = C.shortest_paths(2);
+  expect(after.distance(5) to_be 10);
+  expect(after.distance(7) to_be 16);
+  expect(after.distance(6) to_be 17);
+  expect(after.reachable(1) to_be false);
+  expect(after.path(6) to_be (std::vector<size_t>{2, 5, 7, 6}));
+
+  std::cout << "end const_shortest_paths" << std::endl;
+}
+
+void early_exit_shortest_paths() {
+  std::cout << std::endl << "begin early_exit_shortest_paths" << std::endl;
+  Graph G;
+  for (size_t n = 1; n <= 7; n++) {
+    G.add_vertex(n);
+  }
+  G.add_edge(1,2,2);
+  G.add_edge(1,4,1);
+  G.add_edge(2,4,3);
+  G.add_edge(2,5,10);
+  G.add_edge(3,1,4);
+  G.add_edge(3,6,5);
+  G.add_edge(4,3,2);
+  G.add_edge(4,6,8);
+  G.add_edge(4,7,4);
+  G.add_edge(4,5,2);
+  G.add_edge(5,7,6);
+  G.add_edge(7,6,1);
+
+  // point to point
+  expect(G.shortest_path(2, 6) to_be (std::vector<size_t>{2, 4, 7, 6}));
+  expect(G.shortest_path(2, 1) to_be (std::vector<size_t>{2, 4, 3, 1}));
+  expect(G.shortest_path(2, 2) to_be (std::vector<size_t>{2}));
+  expect(G.shortest_path(6, 1).empty() to_be true);
+  expect(G.shortest_path(2, 42).empty() to_be true);
+  expect(G.shortest_path(42, 2).empty() to_be true);
+
+  // stops once the target is settled - 4 is the closest vertex, so nothing past it is settled
+  Graph::ShortestPaths near = G.shortest_paths(2, {4});
+  expect(near.distance(4) to_be 3);
+  expect(near.distance(6) to_be INFINITY);
+  expect(near.reachable(1) to_be false);
+
+  // several targets, including duplicates and a missing vertex
+  Graph::ShortestPaths many = G.shortest_paths(2, {5, 3, 5, 42});
+  expect(many.distance(5) to_be 5);
+  expect(many.distance(3) to_be 5);
+  expect(many.path(3) to_be (std::vector<size_t>{2, 4, 3}));
+
+  // distance bound without targets
+  Graph::ShortestPaths bounded = G.shortest_paths(1, {}, 3);
+  expect(bounded.distance(1) to_be 0);
+  expect(bounded.distance(4) to_be 1);
+  expect(bounded.distance(2) to_be 2);
+  expect(bounded.distance(3) to_be 3);
+  expect(bounded.distance(5) to_be 3);
+  expect(bounded.reachable(7) to_be false);
+  expect(bounded.reachable(6) to_be false);
+
+  // target beyond the bound
+  Graph::ShortestPaths beyond = G.shortest_paths(1, {6}, 5);
+  expect(beyond.reachable(6) to_be false);
+  expect(beyond.distance(7) to_be 5);
+
+  // a reused result object forgets the previous query
+  Graph::ShortestPaths reused;
+  G.shortest_paths(1, {}, INFINITY, reused);
+  expect(reused.distance(6) to_be 6);
+  G.shortest_paths(1, {4}, INFINITY, reused);
+  expect(reused.distance(4) to_be 1);
+  expect(reused.reachable(6) to_be false);
+
+  std::cout << "end early_exit_shortest_paths" << std::endl;
+}
+
+template <class Queue>
+void drain_queue() {
+  Queue q;
+  q.clear(10);
+  expect(q.empty() to_be true);
+  q.push(3, 7.0);
+  q.push(1, 2.5);
+  q.push(8, 9.0);
+  q.push(8, 1.0); // decrease-key (or a duplicate for the lazy queues)
+  q.push(5, 2.5);
+  expect(q.empty() to_be false);
+
+  std::vector<double> keys;
+  while (!q.empty()) {
+    keys.push_back(q.pop().first);
+  }
+  expect(std::is_sorted(keys.begin(), keys.end()) to_be true);
+  expect(keys.front() to_be 1.0);
+  expect(keys.back() >= 7.0);
+
+  // clearing mid-way leaves a usable queue
+  q.push(4, 3.0);
+  q.push(6, 4.0);
+  q.clear(10);
+  expect(q.empty() to_be true);
+  q.push(6, 5.0);
+  expect(q.pop() to_be (std::pair<double, size_t>(5.0, 6)));
+}
+
+double path_cost(const Graph& g, const std::vector<size_t>& path) {
+  double total = 0;
+  for (size_t i = 1; i < path.size(); i++) {
+    total += g.cost(path[i - 1], path[i]);
+  }
+  return total;
+}
+
+// edges between random IDs 0 .. vertices - 1, repeats and loops included - weights are multiples of 0.25 in
+// [0, max_weight], so paths tie now and then and their lengths add up exactly
+std::vector<Graph::Edge> random_edges(unsigned seed, size_t vertices, size_t edges, double max_weight) {
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<size_t> vertex(0, vertices - 1);
+  std::uniform_int_distribution<int> quarters(0, static_cast<int>(max_weight * 4));
+  std::vector<Graph::Edge> list;
+  list.reserve(edges);
+  for (size_t e = 0; e < edges; e++) {
+    size_t src = vertex(rng), dest = vertex(rng);
+    list.push_back(Graph::Edge{src, dest, quarters(rng) * 0.25});
+  }
+  return list;
+}
+
+// vertices 0 .. vertices - 1 joined by random_edges, built edge by edge - a repeated edge keeps its first weight
+Graph random_graph(unsigned seed, size_t vertices, size_t edges, double max_weight) {
+  Graph g;
+  for (size_t n = 0; n < vertices; n++) {
+    g.add_vertex(n);
+  }
+  for (const Graph::Edge& edge : random_edges(seed, vertices, edges, max_weight)) {
+    g.add_edge(edge.src, edge.dest, edge.weight);
+  }
+  return g;
+}
+
+void pluggable_queues() {
+  std::cout << std::endl << "begin pluggable_queues" << std::endl;
+  drain_queue<BinaryHeap>();
+  drain_queue<DaryHeap<4>>();
+  drain_queue<DaryHeap<2>>();
+  drain_queue<RadixHeap>();
+
+  // all queues agree with the default on a random graph with integer and fractional weights
+  Graph G = random_graph(7, 300, 1500, 20);
+  std::mt19937 rng(7);
+  std::uniform_int_distribution<size_t> vertex(0, 299);
+
+  int mismatches = 0;
+  for (size_t src = 0; src < 300; src += 37) {
+    Graph::ShortestPaths expected = G.shortest_paths(src);
+    Graph::ShortestPaths dary = G.shortest_paths<DaryHeap<4>>(src);
+    Graph::ShortestPaths radix = G.shortest_paths<RadixHeap>(src);
+    for (size_t n = 0; n < 300; n++) {
+      if (dary.distance(n) != expected.distance(n)) mismatches++;
+      if (radix.distance(n) != expected.distance(n)) mismatches++;
+    }
+    size_t dest = vertex(rng);
+    if (G.shortest_path<DaryHeap<4>>(src, dest).size() != expected.path(dest).size()) mismatches++;
+    if (G.shortest_path<RadixHeap>(src, dest).size() != expected.path(dest).size()) mismatches++;
+  }
+  expect(mismatches to_be 0);
+
+  std::cout << "end pluggable_queues" << std::endl;
+}
+
+void bidirectional() {
+  std::cout << std::endl << "begin bidirectional" << std::endl;
+  Graph G;
+  for (size_t n = 1; n <= 7; n++) {
+    G.add_vertex(n);
+  }
+  G.add_edge(1,2,2);
+  G.add_edge(1,4,1);
+  G.add_edge(2,4,3);
+  G.add_edge(2,5,10);
+  G.add_edge(3,1,4);
+  G.add_edge(3,6,5);
+  G.add_edge(4,3,2);
+  G.add_edge(4,6,8);
+  G.add_edge(4,7,4);
+  G.add_edge(4,5,2);
+  G.add_edge(5,7,6);
+  G.add_edge(7,6,1);
+
+  Graph::Path p = G.bidirectional_shortest_path(2, 6);
+  expect(p.distance to_be 8);
+  expect(p.vertices to_be (std::vector<size_t>{2, 4, 7, 6}));
+  p = G.bidirectional_shortest_path(2, 1);
+  expect(p.distance to_be 9);
+  expect(p.vertices to_be (std::vector<size_t>{2, 4, 3, 1}));
+  p = G.bidirectional_shortest_path(3, 3);
+  expect(p.distance to_be 0);
+  expect(p.vertices to_be (std::vector<size_t>{3}));
+  p = G.bidirectional_shortest_path(6, 1);
+  expect(p.distance to_be INFINITY);
+  expect(p.vertices.empty() to_be true);
+  p = G.bidirectional_shortest_path(1, 42);
+  expect(p.distance to_be INFINITY);
+
+  // the reverse index follows edge and vertex removal
+  G.remove_edge(7, 6);
+  p = G.bidirectional_shortest_path(2, 6);
+  expect(p.distance to_be 10);
+  expect(p.vertices to_be (std::vector<size_t>{2, 4, 3, 6}));
+  G.remove_vertex(3);
+  p = G.bidirectional_shortest_path(2, 6);
+  expect(p.distance to_be 11);
+  expect(p.vertices to_be (std::vector<size_t>{2, 4, 6}));
+  expect(G.bidirectional_shortest_path(2, 1).distance to_be INFINITY);
+  G.add_vertex(3);
+  G.add_edge(6, 3, 1);
+  G.add_edge(3, 1, 1);
+  expect(G.bidirectional_shortest_path(2, 1).distance to_be 13);
+
+  // agrees with the one-sided search on a random graph
+  Graph R = random_graph(11, 400, 1600, 10);
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<size_t> vertex(0, 399);
+  for (size_t n = 0; n < 400; n += 50) {
+    R.remove_vertex(n);
+  }
+
+  int mismatches = 0;
+  for (size_t q = 0; q < 200; q++) {
+    size_t src = vertex(rng), dest = vertex(rng);
+    Graph::Path both = R.bidirectional_shortest_path<DaryHeap<4>>(src, dest);
+    double expected = R.shortest_paths(src).distance(dest);
+    if (std::fabs(both.distance - expected) > 1e-9 && both.distance != expected) mismatches++;
+    if (!both.vertices.empty() && std::fabs(path_cost(R, both.vertices) - expected) > 1e-9) mismatches++;
+  }
+  expect(mismatches to_be 0);
+
+  std::cout << "end bidirectional" << std::endl;
+}
+
+void astar() {
+  std::cout << std::endl << "begin astar" << std::endl;
+  // 40 x 40 grid, edges in both directions, weight = length * (1 + a random detour factor)
+  const size_t side = 40;
+  std::mt19937 rng(5);
+  std::uniform_real_distribution<double> detour(0, 0.5);
+  Graph G;
+  for (size_t n = 0; n < side * side; n++) {
+    G.add_vertex(n);
+    expect(G.set_coordinates(n, double(n % side), double(n / side)) to_be true);
+  }
+  for (size_t n = 0; n < side * side; n++) {
+    if (n % side + 1 < side) {
+      double w = 1 + detour(rng);
+      G.add_edge(n, n + 1, w);
+      G.add_edge(n + 1, n, w);
+    }
+    if (n + side < side * side) {
+      double w = 1 + detour(rng);
+      G.add_edge(n, n + side, w);
+      G.add_edge(n + side, n, w);
+    }
+  }
+  expect(G.set_coordinates(side * side, 0, 0) to_be false);
+  expect(G.has_coordinates(5) to_be true);
+  expect(G.coordinates(41) to_be (std::pair<double, double>(1, 1)));
+  expect(std::isnan(G.coordinates(side * side).first) to_be true);
+
+  int mismatches = 0;
+  size_t blind_expanded = 0, guided_expanded = 0;
+  std::uniform_int_distribution<size_t> vertex(0, side * side - 1);
+  for (size_t q = 0; q < 50; q++) {
+    size_t src = vertex(rng), dest = vertex(rng);
+    Graph::ShortestPaths expected = G.shortest_paths(src);
+
+    Graph::Path euclid = G.astar(src, dest, G.euclidean_heuristic(dest));
+    Graph::Path manhattan = G.astar<DaryHeap<4>>(src, dest, G.manhattan_heuristic(dest));
+    if (std::fabs(euclid.distance - expected.distance(dest)) > 1e-9) mismatches++;
+    if (std::fabs(manhattan.distance - expected.distance(dest)) > 1e-9) mismatches++;
+    if (std::fabs(path_cost(G, euclid.vertices) - euclid.distance) > 1e-9) mismatches++;
+    if (euclid.vertices.front() != src || euclid.vertices.back() != dest) mismatches++;
+
+    // count heuristic evaluations as a proxy for explored vertices
+    G.astar(src, dest, [&blind_expanded](size_t) { blind_expanded++; return 0.0; });
+    {
+      Graph::EuclideanHeuristic h = G.euclidean_heuristic(dest);
+      G.astar(src, dest, [&guided_expanded, &h](size_t id) { guided_expanded++; return h(id); });
+    }
+  }
+  expect(mismatches to_be 0);
+  expect(guided_expanded < blind_expanded);
+  std::cout << "  heuristic evaluations: " << guided_expanded << " guided vs " << blind_expanded << " blind" << std::endl;
+
+  // an admissible but inconsistent heuristic still finds the shortest path
+  Graph H;
+  for (size_t n = 1; n <= 5; n++) {
+    H.add_vertex(n);
+  }
+  H.add_edge(1, 2, 1);
+  H.add_edge(1, 3, 4);
+  H.add_edge(2, 3, 1);
+  H.add_edge(3, 4, 5);
+  H.add_edge(4, 5, 1);
+  Graph::Path inconsistent = H.astar(1, 5, [](size_t id) { return id == 2 ? 6.0 : 0.0; });
+  expect(inconsistent.distance to_be 8);
+  expect(inconsistent.vertices to_be (std::vector<size_t>{1, 2, 3, 4, 5}));
+
+  // no coordinates at all falls back to plain dijkstra
+  Graph::Path plain = H.astar(1, 5, H.euclidean_heuristic(5));
+  expect(plain.distance to_be 8);
+  expect(H.astar(5, 1, H.manhattan_heuristic(1)).distance to_be INFINITY);
+  expect(H.astar(1, 42, H.manhattan_heuristic(42)).vertices.empty() to_be true);
+
+  std::cout << "end astar" << std::endl;
+}
+
+void contraction_hierarchy() {
+  std::cout << std::endl << "begin contraction_hierarchy" << std::endl;
+  Graph G;
+  for (size_t n = 1; n <= 7; n++) {
+    G.add_vertex(n);
+  }
+  G.add_edge(1,2,2);
+  G.add_edge(1,4,1);
+  G.add_edge(2,4,3);
+  G.add_edge(2,5,10);
+  G.add_edge(3,1,4);
+  G.add_edge(3,6,5);
+  G.add_edge(4,3,2);
+  G.add_edge(4,6,8);
+  G.add_edge(4,7,4);
+  G.add_edge(4,5,2);
+  G.add_edge(5,7,6);
+  G.add_edge(7,6,1);
+
+  ContractionHierarchy small(G);
+  expect(small.vertex_count() to_be 7);
+  expect(small.distance(2, 1) to_be 9);
+  expect(small.distance(2, 6) to_be 8);
+  expect(small.distance(1, 6) to_be 6);
+  expect(small.distance(3, 3) to_be 0);
+  expect(small.distance(6, 1) to_be INFINITY);
+  expect(small.distance(1, 42) to_be INFINITY);
+  expect(small.shortest_path(2, 6).vertices to_be (std::vector<size_t>{2, 4, 7, 6}));
+  expect(small.shortest_path(2, 1).vertices to_be (std::vector<size_t>{2, 4, 3, 1}));
+  expect(small.shortest_path(5, 5).vertices to_be (std::vector<size_t>{5}));
+  expect(small.shortest_path(6, 2).vertices.empty() to_be true);
+
+  // grid with sparse IDs and a random graph, checked against plain dijkstra
+  std::mt19937 rng(3);
+  std::uniform_real_distribution<double> weight(1, 10);
+  const size_t side = 20;
+  Graph grid;
+  for (size_t n = 0; n < side * side; n++) {
+    grid.add_vertex(n * 3 + 1);
+  }
+  for (size_t n = 0; n < side * side; n++) {
+    if (n % side + 1 < side) { double w = weight(rng); grid.add_edge(n * 3 + 1, n * 3 + 4, w); grid.add_edge(n * 3 + 4, n * 3 + 1, w); }
+    if (n + side < side * side) { grid.add_edge(n * 3 + 1, (n + side) * 3 + 1, weight(rng)); grid.add_edge((n + side) * 3 + 1, n * 3 + 1, weight(rng)); }
+  }
+  Graph random = random_graph(3, 300, 900, 10);
+
+  int mismatches = 0;
+  for (const Graph* g : {&grid, &random}) {
+    ContractionHierarchy ch(*g);
+    std::stringstream file;
+    ch.save(file);
+    ContractionHierarchy loaded = ContractionHierarchy::load(file);
+    if (loaded.shortcut_count() != ch.shortcut_count() || loaded.edge_count() != ch.edge_count()) mismatches++;
+
+    CompactGraph frozen = g->freeze();
+    std::uniform_int_distribution<size_t> index(0, frozen.vertex_count() - 1);
+    for (size_t q = 0; q < 100; q++) {
+      size_t src = frozen.id_of(index(rng)), dest = frozen.id_of(index(rng));
+      double expected = g->shortest_paths(src).distance(dest);
+      Graph::Path p = loaded.shortest_path(src, dest);
+      if (std::fabs(ch.distance(src, dest) - expected) > 1e-9 && expected != INFINITY) mismatches++;
+      if ((ch.distance(src, dest) == INFINITY) != (expected == INFINITY)) mismatches++;
+      if (std::fabs(p.distance - expected) > 1e-9 && expected != INFINITY) mismatches++;
+      if (expected != INFINITY && (p.vertices.front() != src || p.vertices.back() != dest)) mismatches++;
+      if (expected != INFINITY && std::fabs(path_cost(*g, p.vertices) - expected) > 1e-9) mismatches++;
+    }
+  }
+  expect(mismatches to_be 0);
+
+  // corrupt input is rejected
+  std::stringstream garbage("not a hierarchy");
+  expect_throw(ContractionHierarchy::load(garbage), std::runtime_error);
+  std::stringstream truncated;
+  small.save(truncated);
+  std::string bytes = truncated.str();
+  std::stringstream half(bytes.substr(0, bytes.size() / 2));
+  expect_throw(ContractionHierarchy::load(half), std::runtime_error);
+
+  std::cout << "end contraction_hierarchy" << std::endl;
+}
+
+void delta_stepping() {
+  std::cout << std::endl << "begin delta_stepping" << std::endl;
+  CompactGraph C = random_graph(9, 5000, 25000, 100).freeze();
+
+  int mismatches = 0;
+  for (size_t src : {0, 1234, 4999}) {
+    C.dijkstra(src);
+    for (double delta : {0.0, 0.5, 3.0, 1e9}) { // 1e9 puts everything in one bucket, so frontiers get large
+      for (size_t threads : {1, 4}) {
+        DeltaStepping solver(C, delta, threads);
+        std::vector<double> d = solver.run(src);
+        if (d.size() != C.vertex_count()) mismatches++;
+        for (size_t i = 0; i < d.size(); i++) {
+          double expected = C.distance(C.id_of(i));
+          if (expected == INFINITY ? d[i] != INFINITY : std::fabs(d[i] - expected) > 1e-9) mismatches++;
+        }
+        // the solver can be rerun from another source
+        if (solver.run(src)[C.index_of(src)] != 0) mismatches++;
+      }
+    }
+  }
+  expect(mismatches to_be 0);
+
+  DeltaStepping automatic(C);
+  expect(automatic.bucket_width() > 0);
+  expect(automatic.thread_count() >= 1);
+  std::vector<double> missing = ::delta_stepping(C, 5000); // no such ID
+  expect(missing.size() to_be 5000);
+  expect(missing[0] to_be INFINITY);
+  expect(::delta_stepping(CompactGraph(), 0).empty() to_be true);
+
+  // the buckets are a ring of about heaviest / delta, reused as distances grow past it - a delta needing
+  // more buckets than the ring allows is rejected rather than allocating them
+  CompactGraph path({0, 1, 2}, {0, 1, 2, 2}, {1, 2}, {100, 100});
+  for (size_t threads : {1, 4}) {
+    expect(::delta_stepping(path, 0, 1, threads) to_be (std::vector<double>{0, 100, 200}));
+    expect(::delta_stepping(path, 0, 0.3, threads) to_be (std::vector<double>{0, 100, 200}));
+  }
+  expect_throw(DeltaStepping(path, 1e-6, 1), std::invalid_argument);
+
+  // one bucket refills many times - each reached vertex still counts as settled once
+  DeltaStepping single_bucket(C, 1e9, 4);
+  std::vector<double> all = single_bucket.run(0);
+  size_t reached = 0;
+  for (double d : all) {
+    if (d != INFINITY) reached++;
+  }
+  if (SearchStats::enabled) expect(last_search_stats().settled to_be reached);
+
+  std::cout << "end delta_stepping" << std::endl;
+}
+
+void distance_matrix() {
+  std::cout << std::endl << "begin distance_matrix" << std::endl;
+  Graph G = random_graph(21, 600, 2400, 10);
+  std::mt19937 rng(21);
+  std::uniform_int_distribution<size_t> vertex(0, 599);
+
+  std::vector<size_t> sources, targets;
+  for (size_t i = 0; i < 12; i++) {
+    sources.push_back(vertex(rng));
+  }
+  sources.push_back(1000); // missing source
+  for (size_t j = 0; j < 40; j++) {
+    targets.push_back(vertex(rng));
+  }
+  targets.push_back(1001); // missing target
+  targets.push_back(targets.front()); // duplicate target
+
+  std::vector<double> sequential(sources.size() * targets.size(), -1);
+  std::vector<double> threaded(sources.size() * targets.size(), -1);
+  std::vector<double> bucketed(sources.size() * targets.size(), -1);
+  G.distance_matrix(sources, targets, sequential.data(), 1);
+  G.distance_matrix<DaryHeap<4>>(sources, targets, threaded.data(), 4);
+  ContractionHierarchy ch(G);
+  ch.distance_matrix(sources, targets, bucketed.data(), 3);
+
+  int mismatches = 0;
+  for (size_t i = 0; i < sources.size(); i++) {
+    Graph::ShortestPaths expected = G.shortest_paths(sources[i]);
+    for (size_t j = 0; j < targets.size(); j++) {
+      double d = expected.distance(targets[j]);
+      size_t cell = i * targets.size() + j;
+      if (sequential[cell] != d || threaded[cell] != d) mismatches++;
+      if (d == INFINITY ? bucketed[cell] != INFINITY : std::fabs(bucketed[cell] - d) > 1e-9) mismatches++;
+    }
+  }
+  expect(mismatches to_be 0);
+  expect(sequential[sources.size() * targets.size() - 1] to_be INFINITY);
+
+  // empty inputs leave the buffer alone
+  double untouched = -1;
+  G.distance_matrix({}, targets, &untouched);
+  G.distance_matrix(sources, {}, &untouched);
+  ch.distance_matrix(sources, {}, &untouched);
+  expect(untouched to_be -1);
+
+  std::cout << "end distance_matrix" << std::endl;
+}
+
+void arena_storage() {
+  std::cout << std::endl << "begin arena_storage" << std::endl;
+  Arena arena;
+  void* small = arena.allocate(24);
+  void* large = arena.allocate(100000);
+  if (Arena::pooled) {
+    expect(arena.bytes_in_use() to_be 32 + 131072);
+    expect(arena.slab_count() to_be 2);
+    arena.deallocate(small, 24);
+    expect(arena.allocate(20) to_be small); // same size class is reused
+  } else { // GRAPH_NO_ARENA - straight to operator new, nothing is tracked
+    expect(arena.bytes_in_use() to_be 0);
+    expect(arena.slab_count() to_be 0);
+    arena.deallocate(small, 24);
+  }
+  arena.deallocate(large, 100000);
+  arena.release();
+  expect(arena.bytes_reserved() to_be 0);
+  expect(arena.slab_count() to_be 0);
+
+  Graph G;
+  for (size_t n = 1; n <= 100; n++) {
+    G.add_vertex(n);
+  }
+  for (size_t n = 1; n < 100; n++) {
+    G.add_edge(n, n + 1, double(n));
+  }
+  expect((G.arena_bytes() > 0) to_be Arena::pooled);
+  G.dijkstra(1);
+
+  // copies get their own storage, including predecessors
+  Graph copy = G;
+  expect(copy.vertex_count() to_be 100);
+  expect(copy.edge_count() to_be 99);
+  expect(copy.cost(50, 51) to_be 50.0);
+  expect(copy.distance(4) to_be 6);
+  G.clear();
+  expect(G.vertex_count() to_be 0);
+  expect(G.arena_bytes() to_be 0);
+  expect(copy.contains_edge(99, 100) to_be true);
+  expect(copy.shortest_path(1, 4) to_be (std::vector<size_t>{1, 2, 3, 4}));
+
+  // the cleared graph is usable again
+  expect(G.add_vertex(7) to_be true);
+  expect(G.add_vertex(8) to_be true);
+  expect(G.add_edge(7, 8, 2) to_be true);
+  G.remove_vertex(8);
+  expect(G.edge_count() to_be 0);
+
+  copy = G;
+  expect(copy.vertex_count() to_be 1);
+  expect(copy.contains_vertex(7) to_be true);
+
+  std::cout << "end arena_storage" << std::endl;
+}
+
+void vertex_removal() {
+  std::cout << std::endl << "begin vertex_removal" << std::endl;
+  Graph G;
+  for (size_t n = 1; n <= 6; n++) {
+    G.add_vertex(n);
+  }
+  G.add_edge(1, 2);
+  G.add_edge(2, 3);
+  G.add_edge(3, 1);
+  G.add_edge(3, 3); // self loop
+  G.add_edge(3, 4);
+  G.add_edge(4, 5);
+  G.add_edge(5, 3);
+  G.add_edge(6, 1);
+  expect(G.edge_count() to_be 8);
+
+  // single removal with incoming, outgoing and self edges
+  expect(G.remove_vertex(3) to_be true);
+  expect(G.vertex_count() to_be 5);
+  expect(G.edge_count() to_be 3);
+  expect(G.contains_edge(1, 2) to_be true);
+  expect(G.contains_edge(4, 5) to_be true);
+  expect(G.contains_edge(6, 1) to_be true);
+  expect(G.shortest_path(6, 2) to_be (std::vector<size_t>{6, 1, 2}));
+  expect(G.bidirectional_shortest_path(6, 2).distance to_be 2);
+
+  // bulk removal, including an edge between two removed vertices, a missing ID and a repeat
+  G.add_vertex(3);
+  G.add_edge(2, 3);
+  G.add_edge(3, 4);
+  G.add_edge(5, 2);
+  expect(G.edge_count() to_be 6);
+  expect(G.remove_vertices(std::vector<size_t>{2, 3, 42, 2}) to_be 2);
+  expect(G.vertex_count() to_be 4);
+  expect(G.edge_count() to_be 2);
+  expect(G.contains_edge(4, 5) to_be true);
+  expect(G.contains_edge(6, 1) to_be true);
+  expect(G.contains_vertex(2) to_be false);
+  expect(G.shortest_path(4, 5) to_be (std::vector<size_t>{4, 5}));
+  expect(G.bidirectional_shortest_path(5, 4).distance to_be INFINITY);
+
+  // everything at once
+  std::unordered_set<size_t> rest{1, 4, 5, 6};
+  expect(G.remove_vertices(rest) to_be 4);
+  expect(G.vertex_count() to_be 0);
+  expect(G.edge_count() to_be 0);
+
+  // dijkstra() predecessors through a removed vertex or edge are dropped, so copies and printing never follow them
+  Graph P;
+  for (size_t n = 1; n <= 5; n++) {
+    P.add_vertex(n);
+  }
+  P.add_edge(1, 2); P.add_edge(2, 3); P.add_edge(3, 4); P.add_edge(1, 5);
+  P.dijkstra(1);
+  P.remove_vertex(2);
+  P.remove_edge(3, 4);
+  P.remove_vertices(std::vector<size_t>{1});
+  Graph Q(P);
+  std::ostringstream printed;
+  Q.print_shortest_path(3, printed);
+  Q.print_shortest_path(4, printed);
+  Q.print_shortest_path(5, printed);
+  expect(printed.str() to_be "3 distance: 2\n4 distance: 3\n5 distance: 1\n");
+
+  // random graph: bulk removal matches one-by-one removal
+  Graph A = random_graph(13, 500, 3000, 7);
+  Graph B = A;
+  std::vector<size_t> prune;
+  for (size_t n = 0; n < 500; n += 3) {
+    prune.push_back(n);
+  }
+  for (size_t id : prune) {
+    A.remove_vertex(id);
+  }
+  B.remove_vertices(prune);
+  expect(A.vertex_count() to_be B.vertex_count());
+  expect(A.edge_count() to_be B.edge_count());
+  int mismatches = 0;
+  for (size_t src = 1; src < 500; src += 31) {
+    Graph::ShortestPaths a = A.shortest_paths(src), b = B.shortest_paths(src);
+    for (size_t n = 0; n < 500; n++) {
+      if (a.distance(n) != b.distance(n)) mismatches++;
+      if (B.bidirectional_shortest_path(n, src).distance != A.bidirectional_shortest_path(n, src).distance) mismatches++;
+    }
+  }
+  expect(mismatches to_be 0);
+
+  std::cout << "end vertex_removal" << std::endl;
+}
+
+void bulk_construction() {
+  std::cout << std::endl << "begin bulk_construction" << std::endl;
+  std::vector<Graph::Edge> edges{
+    {1, 2, 2}, {1, 4, 1}, {2, 4, 3}, {2, 5, 10}, {3, 1, 4}, {3, 6, 5},
+    {4, 3, 2}, {4, 6, 8}, {4, 7, 4}, {4, 5, 2}, {5, 7, 6}, {7, 6, 1},
+    {4, 3, 99}, // repeated edge, the first weight wins
+  };
+  Graph G = Graph::from_edges(edges, {1, 8});
+  expect(G.vertex_count() to_be 8);
+  expect(G.edge_count() to_be 12);
+  expect(G.contains_vertex(8) to_be true);
+  expect(G.cost(4, 3) to_be 2.0);
+  expect(G.cost(3, 4) to_be INFINITY);
+  expect(G.shortest_path(2, 6) to_be (std::vector<size_t>{2, 4, 7, 6}));
+  expect(G.bidirectional_shortest_path(2, 1).distance to_be 9);
+
+  // the result is an ordinary graph
+  expect(G.add_edge(8, 1, 1) to_be true);
+  expect(G.add_edge(8, 1, 1) to_be false);
+  expect(G.remove_vertex(4) to_be true);
+  expect(G.edge_count() to_be 7);
+
+  Graph E = Graph::from_edges({});
+  expect(E.vertex_count() to_be 0);
+  expect(E.edge_count() to_be 0);
+
+  // bulk and incremental construction agree on a random edge list with repeats
+  std::vector<Graph::Edge> random = random_edges(17, 300, 2000, 10);
+  Graph incremental = random_graph(17, 300, 2000, 10);
+  std::vector<size_t> all(300);
+  for (size_t n = 0; n < 300; n++) {
+    all[n] = n;
+  }
+  Graph bulk = Graph::from_edges(random, all);
+  expect(bulk.vertex_count() to_be incremental.vertex_count());
+  expect(bulk.edge_count() to_be incremental.edge_count());
+  int mismatches = 0;
+  for (const Graph::Edge& edge : random) {
+    if (bulk.cost(edge.src, edge.dest) != incremental.cost(edge.src, edge.dest)) mismatches++;
+    double expected = incremental.shortest_paths(edge.dest).distance(edge.src);
+    if (std::fabs(bulk.shortest_paths(edge.dest).distance(edge.src) - expected) > 1e-9 && expected != INFINITY) mismatches++;
+  }
+  expect(mismatches to_be 0);
+
+  std::cout << "end bulk_construction" << std::endl;
+}
+
+
+void mapped_format() {
+  std::cout << std::endl << "begin mapped_format" << std::endl;
+  Graph G;
+  for (size_t n = 1; n <= 7; n++) {
+    G.add_vertex(n * 10);
+  }
+  G.add_edge(10, 20, 2); G.add_edge(10, 40, 1); G.add_edge(20, 40, 3); G.add_edge(20, 50, 10);
+  G.add_edge(30, 10, 4); G.add_edge(30, 60, 5); G.add_edge(40, 30, 2); G.add_edge(40, 60, 8);
+  G.add_edge(40, 70, 4); G.add_edge(40, 50, 2); G.add_edge(50, 70, 6); G.add_edge(70, 60, 1);
+
+  const std::string file = "graph_tests_mapped.bin";
+  G.save(file);
+  CompactGraph M = Graph::open_mapped(file);
+  std::remove(file.c_str()); // the mapping outlives the directory entry
+  expect(M.mapped() to_be true);
+  expect(M.vertex_count() to_be 7);
+  expect(M.edge_count() to_be 12);
+  expect(M.contains_vertex(30) to_be true);
+  expect(M.contains_vertex(35) to_be false);
+  expect(M.contains_edge(40, 30) to_be true);
+  expect(M.contains_edge(30, 40) to_be false);
+  expect(M.cost(20, 50) to_be 10.0);
+
+  // queries run on the mapped arrays and agree with the graph they came from
+  int mismatches = 0;
+  for (size_t src = 10; src <= 70; src += 10) {
+    M.dijkstra(src);
+    Graph::ShortestPaths paths = G.shortest_paths(src);
+    for (size_t dest = 10; dest <= 70; dest += 10) {
+      if (M.distance(dest) != paths.distance(dest)) mismatches++;
+    }
+  }
+  expect(mismatches to_be 0);
+  CompactGraph copy = M;
+  expect(copy.mapped() to_be true);
+  expect(::delta_stepping(copy, 20)[copy.index_of(60)] to_be 8.0);
+
+  // an empty graph round trips too
+  Graph().save(file);
+  CompactGraph E = CompactGraph::open_mapped(file);
+  expect(E.vertex_count() to_be 0);
+  expect(E.edge_count() to_be 0);
+
+  // anything but an intact file is rejected
+  expect_throw(CompactGraph::open_mapped("no_such_graph_file.bin"), std::runtime_error);
+  {
+    std::ofstream garbage(file, std::ios::binary);
+    garbage << "not a graph file, not even close";
+  }
+  expect_throw(CompactGraph::open_mapped(file), std::runtime_error);
+  std::stringstream bytes;
+  G.freeze().save(bytes);
+  {
+    std::ofstream truncated(file, std::ios::binary);
+    truncated << bytes.str().substr(0, bytes.str().size() - 8);
+  }
+  expect_throw(CompactGraph::open_mapped(file), std::runtime_error);
+  std::remove(file.c_str());
+
+  std::cout << "end mapped_format" << std::endl;
+}
+
+void graph_readers() {
+  std::cout << std::endl << "begin graph_readers" << std::endl;
+  std::stringstream list("# comment\n1 2 2.5\n2 3\r\n\n  3 1 4  \n% another comment\n1 2 9\n");
+  Graph L = read_edge_list(list);
+  expect(L.vertex_count() to_be 3);
+  expect(L.edge_count() to_be 3);
+  expect(L.cost(1, 2) to_be 2.5); // repeated edges keep the first weight, like add_edge
+  expect(L.cost(2, 3) to_be 1.0);
+  expect(L.cost(3, 1) to_be 4.0);
+
+  std::stringstream gr("c 9th DIMACS challenge format\np sp 5 4\na 1 2 7\na 2 3 1\nc mid-file comment\na 3 1 2\na 1 3 10\n");
+  Graph D = read_dimacs(gr);
+  expect(D.vertex_count() to_be 5); // 4 and 5 exist without arcs
+  expect(D.contains_vertex(5) to_be true);
+  expect(D.edge_count() to_be 4);
+  expect(D.shortest_paths(1).distance(3) to_be 8.0);
+
+  std::stringstream mm("%%MatrixMarket matrix coordinate real symmetric\n% comment\n4 4 3\n1 2 0.5\n3 3 2\n4 1 1e1\n");
+  Graph M = read_matrix_market(mm);
+  expect(M.vertex_count() to_be 4);
+  expect(M.edge_count() to_be 5); // off-diagonal entries in both directions
+  expect(M.cost(2, 1) to_be 0.5);
+  expect(M.cost(1, 4) to_be 10.0);
+  expect(M.cost(3, 3) to_be 2.0);
+  std::stringstream pattern("%%MatrixMarket matrix coordinate pattern general\n3 3 2\n1 2\n2 3\n");
+  Graph P = read_matrix_market(pattern);
+  expect(P.edge_count() to_be 2);
+  expect(P.cost(2, 3) to_be 1.0);
+
+  // malformed input
+  std::stringstream bad_list("1 2 x\n");
+  expect_throw(read_edge_list(bad_list), std::runtime_error);
+  std::stringstream bad_arc("p sp 2 1\na 1 2\n");
+  expect_throw(read_dimacs(bad_arc), std::runtime_error);
+  std::stringstream dense("%%MatrixMarket matrix array real general\n2 2\n1\n2\n3\n4\n");
+  expect_throw(read_matrix_market(dense), std::runtime_error);
+  std::stringstream no_size("%%MatrixMarket matrix coordinate real general\n% only comments\n");
+  expect_throw(read_matrix_market(no_size), std::runtime_error);
+  std::stringstream missing_value("%%MatrixMarket matrix coordinate real general\n2 2 1\n1 2\n");
+  expect_throw(read_matrix_market(missing_value), std::runtime_error);
+
+  // a file bigger than one chunk, read streaming and mapped across threads
+  const std::string file = "graph_tests_edges.gr";
+  std::vector<Graph::Edge> edges = random_edges(5, 5000, 200000, 100);
+  {
+    std::ofstream out(file);
+    out << "c random graph\np sp 5000 200000\n";
+    for (Graph::Edge& edge : edges) {
+      edge.src++; // DIMACS IDs start at 1
+      edge.dest++;
+      out << "a " << edge.src << " " << edge.dest << " " << edge.weight << "\n";
+    }
+  }
+  Graph expected = Graph::from_edges(edges);
+  std::ifstream in(file);
+  Graph streamed = read_dimacs(in);
+  Graph mapped = read_dimacs(file, 4);
+  std::remove(file.c_str());
+  int mismatches = 0;
+  for (const Graph* g : {&streamed, &mapped}) {
+    if (g->vertex_count() != 5000 || g->edge_count() != expected.edge_count()) mismatches++;
+    for (const Graph::Edge& edge : edges) {
+      if (g->cost(edge.src, edge.dest) != expected.cost(edge.src, edge.dest)) mismatches++;
+    }
+  }
+  expect(mismatches to_be 0);
+  expect_throw(read_dimacs("no_such_graph_file.gr"), std::runtime_error);
+
+  std::cout << "end graph_readers" << std::endl;
+}
+
+void dynamic_shortest_paths() {
+  std::cout << std::endl << "begin dynamic_shortest_paths" << std::endl;
+  Graph G;
+  for (size_t n = 1; n <= 7; n++) {
+    G.add_vertex(n);
+  }
+  G.add_edge(1, 2, 2); G.add_edge(1, 4, 1); G.add_edge(2, 4, 3); G.add_edge(2, 5, 10);
+  G.add_edge(3, 1, 4); G.add_edge(3, 6, 5); G.add_edge(4, 3, 2); G.add_edge(4, 6, 8);
+  G.add_edge(4, 7, 4); G.add_edge(4, 5, 2); G.add_edge(5, 7, 6); G.add_edge(7, 6, 1);
+
+  expect(G.update_weight(4, 7, 5) to_be true);
+  expect(G.cost(4, 7) to_be 5.0);
+  expect(G.update_weight(7, 4, 5) to_be false);
+  expect(G.update_weight(4, 8, 5) to_be false);
+  expect(G.update_weight(4, 7, 4) to_be true);
+
+  DynamicShortestPaths D(G, 1);
+  expect(D.distance(6) to_be 6.0);
+  expect(D.path(6) to_be (std::vector<size_t>{1, 4, 7, 6}));
+  expect(D.update_weight(7, 6, 10) to_be true); // tree edge gets dearer, 6 is now reached through 3
+  expect(D.distance(6) to_be 8.0);
+  expect(D.predecessor(6) to_be 3);
+  expect(D.remove_edge(1, 4) to_be true); // cuts off most of the tree
+  expect(D.distance(4) to_be 5.0);
+  expect(D.distance(6) to_be 12.0);
+  expect(D.add_edge(1, 6, 1) to_be true);
+  expect(D.distance(6) to_be 1.0);
+  expect(D.add_edge(1, 6, 1) to_be false);
+  expect_throw(D.add_edge(6, 3, -1), std::domain_error); // refused before the graph changes
+  expect(G.contains_edge(6, 3) to_be false);
+  expect_throw(D.update_weight(1, 6, -1), std::domain_error);
+  expect(G.cost(1, 6) to_be 1.0);
+  expect(D.distance(6) to_be 1.0);
+  expect(D.remove_vertex(2) to_be true);
+  expect(D.reachable(4) to_be false);
+  expect(D.distance(6) to_be 1.0);
+  expect(D.add_vertex(9) to_be true);
+  expect(D.reachable(9) to_be false);
+  expect(D.remove_vertex(1) to_be true); // the source
+  expect(D.reachable(6) to_be false);
+  expect(D.add_vertex(1) to_be true);
+  expect(D.distance(1) to_be 0.0);
+
+  // a far away change only touches the end of a long chain
+  Graph chain;
+  for (size_t n = 0; n < 1000; n++) {
+    chain.add_vertex(n);
+    if (n > 0) chain.add_edge(n - 1, n, 1);
+  }
+  DynamicShortestPaths C(chain, 0);
+  expect(C.update_weight(989, 990, 2) to_be true);
+  expect(C.distance(999) to_be 1000.0);
+  expect((C.touched() <= 20) to_be true);
+  expect(C.update_weight(998, 999, 0.5) to_be true); // only 999 moves
+  expect((C.touched() <= 2) to_be true);
+  expect(C.distance(999) to_be 999.5);
+  expect(C.add_vertex(5000) to_be true);
+  expect(C.remove_vertex(5000) to_be true); // unreachable - nothing to repair, not even the last change's subtree
+  expect(C.touched() to_be 0);
+  expect(C.distance(999) to_be 999.5);
+
+  // random changes agree with recomputing from scratch
+  Graph R = random_graph(11, 200, 600, 10);
+  std::mt19937 rng(11);
+  std::uniform_int_distribution<size_t> vertex(0, 199);
+  std::uniform_real_distribution<double> weight(1, 10);
+  std::uniform_int_distribution<int> action(0, 9);
+  DynamicShortestPaths tracker(R, 0);
+  int mismatches = 0;
+  for (size_t step = 0; step < 400; step++) {
+    size_t a = vertex(rng), b = vertex(rng);
+    int what = action(rng);
+    if (what < 4) tracker.update_weight(a, b, weight(rng));
+    else if (what < 6) tracker.add_edge(a, b, weight(rng));
+    else if (what < 9) tracker.remove_edge(a, b);
+    else if (a != 0) { tracker.remove_vertex(a); tracker.add_vertex(a); }
+    if (what < 4 && !R.contains_edge(a, b)) {
+      // update_weight on a missing edge is a no-op, pick an existing one instead
+      for (size_t n = 0; n < 200 && !R.contains_edge(a, b); n++) b = n;
+      if (R.contains_edge(a, b)) tracker.update_weight(a, b, weight(rng));
+    }
+
+    Graph::ShortestPaths expected = R.shortest_paths(0);
+    for (size_t n = 0; n < 200; n++) {
+      double d = expected.distance(n);
+      if ((d == INFINITY) != (tracker.distance(n) == INFINITY)) mismatches++;
+      else if (d != INFINITY && std::fabs(d - tracker.distance(n)) > 1e-9) mismatches++;
+      else if (d != INFINITY && std::fabs(path_cost(R, tracker.path(n)) - d) > 1e-9) mismatches++;
+    }
+  }
+  expect(mismatches to_be 0);
+
+  std::cout << "end dynamic_shortest_paths" << std::endl;
+}
+
+void path_cache() {
+  std::cout << std::endl << "begin path_cache" << std::endl;
+  Graph G;
+  for (size_t n = 1; n <= 7; n++) {
+    G.add_vertex(n);
+  }
+  G.add_edge(1, 2, 2); G.add_edge(1, 4, 1); G.add_edge(2, 4, 3); G.add_edge(2, 5, 10);
+  G.add_edge(3, 1, 4); G.add_edge(3, 6, 5); G.add_edge(4, 3, 2); G.add_edge(4, 6, 8);
+  G.add_edge(4, 7, 4); G.add_edge(4, 5, 2); G.add_edge(5, 7, 6); G.add_edge(7, 6, 1);
+
+  // every mutation moves the version, failed ones and queries do not
+  size_t version = G.version();
+  expect(G.add_edge(1, 2, 5) to_be false);
+  G.shortest_paths(1);
+  expect(G.version() to_be version);
+  G.update_weight(1, 2, 2);
+  expect((G.version() != version) to_be true);
+
+  size_t entry = G.shortest_paths(1).memory_bytes() + 64; // room for one result and its bookkeeping
+  ShortestPathCache cache(G, 2 * entry);
+  expect(cache.distance(1, 6) to_be 6.0);
+  expect(cache.distance(1, 5) to_be 3.0);
+  expect(cache.path(1, 6) to_be (std::vector<size_t>{1, 4, 7, 6}));
+  expect(cache.stats().misses to_be 1);
+  expect(cache.stats().hits to_be 2);
+  expect(cache.size() to_be 1);
+
+  // least recently used goes first
+  cache.get(2);
+  cache.get(1);
+  cache.get(3); // evicts 2
+  expect(cache.stats().evictions to_be 1);
+  cache.get(1);
+  expect(cache.stats().misses to_be 3);
+  cache.get(2);
+  expect(cache.stats().misses to_be 4);
+  expect((cache.bytes_used() <= cache.budget_bytes()) to_be true);
+
+  // a held result outlives its eviction, a mutation drops every entry
+  ShortestPathCache::Result held = cache.get(2);
+  G.remove_edge(4, 7);
+  expect(held->distance(5) to_be 5.0);
+  expect(cache.distance(1, 6) to_be 8.0);
+  expect(cache.stats().invalidations to_be 2);
+  expect(cache.size() to_be 1);
+
+  // results bigger than the whole budget are returned but never kept
+  ShortestPathCache tiny(G, 16);
+  expect(tiny.distance(1, 6) to_be 8.0);
+  expect(tiny.size() to_be 0);
+
+  // concurrent lookups
+  ShortestPathCache shared(G, 64 * entry);
+  std::vector<std::thread> workers;
+  std::vector<int> wrong(4, 0);
+  for (size_t t = 0; t < 4; t++) {
+    workers.emplace_back([&shared, &G, &wrong, t]() {
+      for (size_t q = 0; q < 200; q++) {
+        size_t src = 1 + (q + t) % 7;
+        if (shared.distance(src, 6) != G.shortest_paths(src).distance(6)) wrong[t]++;
+      }
+    });
+  }
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  expect(wrong to_be (std::vector<int>(4, 0)));
+  expect(shared.stats().hits + shared.stats().misses to_be 800);
+
+  std::cout << "end path_cache" << std::endl;
+}
+
+void search_stats() {
+  std::cout << std::endl << "begin search_stats" << std::endl;
+  Graph G;
+  for (size_t n = 1; n <= 7; n++) {
+    G.add_vertex(n);
+  }
+  G.add_edge(1, 2, 2); G.add_edge(1, 4, 1); G.add_edge(2, 4, 3); G.add_edge(2, 5, 10);
+  G.add_edge(3, 1, 4); G.add_edge(3, 6, 5); G.add_edge(4, 3, 2); G.add_edge(4, 6, 8);
+  G.add_edge(4, 7, 4); G.add_edge(4, 5, 2); G.add_edge(5, 7, 6); G.add_edge(7, 6, 1);
+
+  std::vector<std::string> seen;
+  set_stats_sink([&seen](const SearchStats& stats) { seen.push_back(stats.algorithm); });
+
+  G.shortest_paths(1);
+  const SearchStats& stats = last_search_stats();
+  if (SearchStats::enabled) {
+    expect(stats.source to_be 1);
+    expect(stats.settled to_be 7);
+    expect(stats.relaxed to_be 12); // every edge leaves a reachable vertex
+    expect((stats.pushes >= 7) to_be true);
+    expect(stats.pushes to_be stats.settled + stats.stale_pops); // a full run pops everything it pushed
+    expect((stats.peak_queue >= 1) to_be true);
+    expect(stats.phase_count to_be 2);
+    expect(std::string(stats.phases[0].name) to_be "setup");
+    expect(std::string(stats.phases[1].name) to_be "search");
+    expect((stats.total_ms >= stats.phases[1].ms) to_be true);
+
+    G.shortest_paths(1, {4}); // stops at the first settled target
+    expect(last_search_stats().settled to_be 2);
+
+    G.astar(1, 6, [](size_t) { return 0.0; });
+    G.bidirectional_shortest_path(1, 6);
+    CompactGraph C = G.freeze();
+    C.dijkstra(1);
+    expect(last_search_stats().settled to_be 7);
+    ContractionHierarchy(G).distance(1, 6);
+    ::delta_stepping(C, 1);
+    expect(last_search_stats().settled to_be 7);
+    expect(seen to_be (std::vector<std::string>{"dijkstra", "dijkstra", "astar", "bidirectional_dijkstra", "compact_dijkstra", "ch_query", "delta_stepping"}));
+  } else {
+    // compiled out: nothing is counted and the sink never runs
+    G.astar(1, 6, [](size_t) { return 0.0; });
+    expect(stats.settled to_be 0);
+    expect(stats.phase_count to_be 0);
+    expect(seen.size() to_be 0);
+  }
+  set_stats_sink(nullptr);
+
+  std::cout << "end search_stats" << std::endl;
+}
+
+// every member of the narrow instantiations has to compile, not just the ones the tests call
+template class BasicGraph<uint32_t, float>;
+template class BasicGraph<uint32_t, uint32_t>;
+
+void templated_graph() {
+  std::cout << std::endl << "begin templated_graph" << std::endl;
+  Graph G;
+  BasicGraph<uint32_t, float> F;
+  BasicGraph<uint32_t, uint32_t> U;
+  for (uint32_t n = 1; n <= 7; n++) {
+    G.add_vertex(n);
+    F.add_vertex(n);
+    U.add_vertex(n);
+  }
+  std::vector<Graph::Edge> edges = {{1, 2, 2}, {1, 4, 1}, {2, 4, 3}, {2, 5, 10}, {3, 1, 4}, {3, 6, 5},
+                                    {4, 3, 2}, {4, 6, 8}, {4, 7, 4}, {4, 5, 2}, {5, 7, 6}, {7, 6, 1}};
+  for (const Graph::Edge& e : edges) {
+    G.add_edge(e.src, e.dest, e.weight);
+    F.add_edge(static_cast<uint32_t>(e.src), static_cast<uint32_t>(e.dest), static_cast<float>(e.weight));
+    U.add_edge(static_cast<uint32_t>(e.src), static_cast<uint32_t>(e.dest), static_cast<uint32_t>(e.weight));
+  }
+  expect(F.edge_count() to_be G.edge_count());
+  expect(U.cost(2, 5) to_be 10);
+
+  // integer weights pick the bucket queue, everything else keeps the binary heap
+  expect((std::is_same<BasicGraph<uint32_t, uint32_t>::DefaultQueue, RadixHeap>::value) to_be true);
+  expect((std::is_same<BasicGraph<uint32_t, float>::DefaultQueue, BinaryHeap>::value) to_be true);
+  expect((std::is_same<Graph::DefaultQueue, BinaryHeap>::value) to_be true);
+
+  // same distances and routes whatever the types
+  Graph::ShortestPaths expected = G.shortest_paths(1);
+  BasicGraph<uint32_t, float>::ShortestPaths narrow = F.shortest_paths(1);
+  BasicGraph<uint32_t, uint32_t>::ShortestPaths integral = U.shortest_paths(1);
+  for (uint32_t n = 1; n <= 7; n++) {
+    expect(narrow.distance(n) to_be expected.distance(n));
+    expect(integral.distance(n) to_be expected.distance(n));
+  }
+  expect(integral.path(6) to_be (std::vector<uint32_t>{1, 4, 7, 6}));
+  expect(U.shortest_path(1, 6) to_be (std::vector<uint32_t>{1, 4, 7, 6}));
+  expect(U.bidirectional_shortest_path(1, 6).distance to_be 6);
+  expect(F.astar(1, 6, [](uint32_t) { return 0.0; }).vertices to_be (std::vector<uint32_t>{1, 4, 7, 6}));
+  expect(U.freeze().cost(2, 5) to_be 10);
+
+  // bulk construction and removal go through the same code
+  BasicGraph<uint32_t, uint32_t> B = BasicGraph<uint32_t, uint32_t>::from_edges({{1, 2, 3}, {2, 3, 4}, {1, 3, 9}});
+  expect(B.shortest_paths(1).distance(3) to_be 7);
+  expect(B.remove_vertex(2) to_be true);
+  expect(B.shortest_paths(1).distance(3) to_be 9);
+
+  // narrow adjacency nodes take less arena than size_t / double ones
+  Graph wide;
+  BasicGraph<uint32_t, float> narrow_ring;
+  for (uint32_t n = 0; n < 20000; n++) {
+    wide.add_vertex(n);
+    narrow_ring.add_vertex(n);
+  }
+  for (uint32_t n = 0; n < 20000; n++) {
+    wide.add_edge(n, (n + 1) % 20000, 1);
+    narrow_ring.add_edge(n, (n + 1) % 20000, 1);
+  }
+  if (Arena::pooled) expect((narrow_ring.arena_bytes() < wide.arena_bytes()) to_be true);
+
+  std::cout << "end templated_graph" << std::endl;
+}
+
+void dense_ids() {
+  std::cout << std::endl << "begin dense_ids" << std::endl;
+  Graph S;
+  Graph D(Graph::dense_ids);
+  expect(S.id_mode() to_be Graph::sparse_ids);
+  expect(D.id_mode() to_be Graph::dense_ids);
+  for (size_t n = 0; n < 7; n++) {
+    S.add_vertex(n);
+    D.add_vertex(n);
+  }
+  expect(D.add_vertex(3) to_be false);
+  std::vector<Graph::Edge> edges = {{0, 1, 2}, {0, 3, 1}, {1, 3, 3}, {1, 4, 10}, {2, 0, 4}, {2, 5, 5},
+                                    {3, 2, 2}, {3, 5, 8}, {3, 6, 4}, {3, 4, 2}, {4, 6, 6}, {6, 5, 1}};
+  for (const Graph::Edge& e : edges) {
+    S.add_edge(e.src, e.dest, e.weight);
+    D.add_edge(e.src, e.dest, e.weight);
+  }
+  expect(D.add_edge(0, 9) to_be false); // past the end of the table
+  expect(D.contains_edge(9, 0) to_be false);
+  expect(D.vertex_count() to_be 7);
+  expect(D.edge_count() to_be 12);
+
+  // every search answers the same as on hashed IDs
+  Graph::ShortestPaths expected = S.shortest_paths(0);
+  Graph::ShortestPaths dense = D.shortest_paths(0);
+  for (size_t n = 0; n < 7; n++) {
+    expect(dense.distance(n) to_be expected.distance(n));
+    expect(dense.predecessor(n) to_be expected.predecessor(n));
+  }
+  expect(D.bidirectional_shortest_path(0, 5).vertices to_be S.bidirectional_shortest_path(0, 5).vertices);
+  expect(D.astar(0, 5, [](size_t) { return 0.0; }).distance to_be 6);
+  D.dijkstra(0);
+  expect(D.distance(5) to_be 6);
+  expect(D.freeze().cost(3, 6) to_be 4);
+
+  // gaps are allowed, the table just grows to the largest ID
+  expect(D.add_vertex(20) to_be true);
+  expect(D.contains_vertex(15) to_be false);
+  expect(D.vertex_count() to_be 8);
+  expect(D.add_edge(6, 20, 1) to_be true);
+  expect(D.shortest_paths(0).distance(20) to_be 6);
+
+  // removal leaves a gap that can be filled again
+  expect(D.remove_vertex(3) to_be true);
+  expect(D.contains_vertex(3) to_be false);
+  expect(D.shortest_paths(0).distance(5) to_be 2 + 10 + 6 + 1);
+  expect(D.add_vertex(3) to_be true);
+  expect(D.remove_vertices(std::vector<size_t>{4, 20, 99}) to_be 2);
+  expect(D.edge_count() to_be 4);
+
+  // copies keep the mode
+  Graph C(D);
+  expect(C.id_mode() to_be Graph::dense_ids);
+  expect(C.cost(2, 5) to_be 5);
+  Graph A;
+  A = D;
+  expect(A.id_mode() to_be Graph::dense_ids);
+  expect(A.contains_vertex(3) to_be true);
+
+  // bulk construction and incremental repair work the same way
+  Graph B = Graph::from_edges(edges, {}, Graph::dense_ids);
+  expect(B.id_mode() to_be Graph::dense_ids);
+  expect(B.shortest_paths(0).distance(5) to_be 6);
+  DynamicShortestPaths tree(B, 0);
+  tree.remove_edge(6, 5);
+  expect(tree.distance(5) to_be 8); // 0 -> 3 -> 2 -> 5
+  tree.remove_vertex(2);
+  expect(tree.distance(5) to_be 9);
+
+  std::cout << "end dense_ids" << std::endl;
+}
+
+void move_and_share() {
+  std::cout << std::endl << "begin move_and_share" << std::endl;
+  Graph G;
+  for (size_t n = 1; n <= 5; n++) {
+    G.add_vertex(n);
+  }
+  G.add_edge(1, 2, 1); G.add_edge(2, 3, 2); G.add_edge(3, 4, 3); G.add_edge(4, 5, 4); G.add_edge(1, 5, 20);
+  size_t arena = G.arena_bytes();
+
+  // moves take the arena along instead of copying vertices
+  expect(std::is_nothrow_move_constructible<Graph>::value to_be true);
+  expect(std::is_nothrow_move_assignable<Graph>::value to_be true);
+  Graph M(std::move(G));
+  expect(M.arena_bytes() to_be arena);
+  expect(M.vertex_count() to_be 5);
+  expect(M.edge_count() to_be 5);
+  expect(M.shortest_paths(1).distance(5) to_be 10);
+
+  // the moved from graph is empty and still usable
+  expect(G.vertex_count() to_be 0);
+  expect(G.edge_count() to_be 0);
+  expect(G.arena_bytes() to_be 0);
+  expect(G.contains_vertex(1) to_be false);
+  expect(G.add_vertex(7) to_be true);
+  expect(G.add_vertex(8) to_be true);
+  expect(G.add_edge(7, 8, 3) to_be true);
+  expect(G.shortest_paths(7).distance(8) to_be 3);
+
+  // move assignment drops what was there and changes the version
+  size_t version = G.version();
+  G = std::move(M);
+  expect((G.version() != version) to_be true);
+  expect(G.contains_vertex(7) to_be false);
+  expect(G.shortest_paths(1).distance(5) to_be 10);
+  expect(M.vertex_count() to_be 0);
+  M.clear();
+
+  // growing a vector of graphs moves them
+  std::vector<Graph> graphs;
+  for (size_t i = 0; i < 8; i++) {
+    graphs.push_back(Graph::from_edges({{1, 2, static_cast<double>(i)}}));
+  }
+  expect(graphs[5].cost(1, 2) to_be 5);
+
+  // snapshots share the graph until it is edited
+  SharedGraph<> shared(std::move(G));
+  std::shared_ptr<const Graph> before = shared.snapshot();
+  expect(&*shared to_be before.get());
+  expect(shared.shared() to_be true);
+  expect(shared->edge_count() to_be 5);
+
+  shared.edit().remove_edge(3, 4); // copies once, the snapshot keeps the old graph
+  expect(&*shared not_to_be before.get());
+  expect(shared.shared() to_be false);
+  expect(shared->shortest_paths(1).distance(5) to_be 20);
+  expect(before->shortest_paths(1).distance(5) to_be 10);
+  expect(before->edge_count() to_be 5);
+
+  Graph* body = &shared.edit(); // nothing shares it now, so no copy
+  body->add_edge(3, 4, 1);
+  expect(&*shared to_be body);
+  expect(shared->shortest_paths(1).distance(5) to_be 8);
+
+  SharedGraph<> other = shared; // handles share too
+  other.edit().update_weight(1, 2, 5);
+  expect(shared->cost(1, 2) to_be 1);
+  expect(other->cost(1, 2) to_be 5);
+
+  std::cout << "end move_and_share" << std::endl;
+}
+
+void multi_source() {
+  std::cout << std::endl << "begin multi_source" << std::endl;
+  // a line 1 - 2 - 3 - 4 - 5 - 6 - 7 with edges both ways, plus a spur 4 -> 8
+  Graph G;
+  for (size_t n = 1; n <= 8; n++) {
+    G.add_vertex(n);
+  }
+  for (size_t n = 1; n < 7; n++) {
+    G.add_edge(n, n + 1, 1);
+    G.add_edge(n + 1, n, 1);
+  }
+  G.add_edge(4, 8, 5);
+
+  // depots at both ends - every vertex goes to the closer one
+  Graph::ShortestPaths nearest = G.multi_source_shortest_paths({1, 7});
+  expect(nearest.distance(1) to_be 0);
+  expect(nearest.distance(3) to_be 2);
+  expect(nearest.distance(5) to_be 2);
+  expect(nearest.distance(8) to_be 8);
+  expect(nearest.nearest_source(2) to_be 1);
+  expect(nearest.nearest_source(6) to_be 7);
+  expect(nearest.nearest_source(4) to_be 1); // a tie goes to the source listed first
+  expect(nearest.nearest_source(8) to_be 1);
+  expect(nearest.predecessor(1) to_be Graph::npos);
+  expect(nearest.predecessor(5) to_be 6);
+  expect(nearest.path(5) to_be (std::vector<size_t>{7, 6, 5}));
+  expect(nearest.source() to_be 1);
+
+  // same answer as the minimum over one search per source
+  Graph::ShortestPaths from1 = G.shortest_paths(1), from7 = G.shortest_paths(7);
+  for (size_t n = 1; n <= 8; n++) {
+    expect(nearest.distance(n) to_be std::min(from1.distance(n), from7.distance(n)));
+  }
+
+  // offsets shift the boundary - e.g. a depot that is busy for a while
+  Graph::ShortestPaths offset = G.multi_source_shortest_paths({1, 7}, {3, 0});
+  expect(offset.distance(1) to_be 3);
+  expect(offset.distance(2) to_be 4);
+  expect(offset.nearest_source(3) to_be 7);
+  expect(offset.distance(3) to_be 4);
+  expect(offset.nearest_source(2) to_be 1);
+
+  // missing sources are ignored, duplicates keep the smaller offset, a source can be reached through another
+  Graph::ShortestPaths odd = G.multi_source_shortest_paths({99, 4, 4, 5}, {0, 6, 2, 0});
+  expect(odd.distance(4) to_be 1);
+  expect(odd.nearest_source(4) to_be 5);
+  expect(odd.nearest_source(8) to_be 5);
+  expect(odd.distance(8) to_be 6);
+  expect(G.multi_source_shortest_paths({}).reachable(1) to_be false);
+  expect(G.multi_source_shortest_paths({99}).reachable(1) to_be false);
+  expect_throw(G.multi_source_shortest_paths({1, 7}, {1}), std::invalid_argument);
+  expect_throw(G.multi_source_shortest_paths({1, 7}, {0, -1}), std::invalid_argument);
+  expect_throw(G.multi_source_shortest_paths({1, 7}, {NAN, 0}), std::invalid_argument);
+  expect_throw(G.multi_source_shortest_paths<RadixHeap>({1, 7}, {-1, 0}), std::invalid_argument); // would sort after every key
+  Graph::ShortestPaths negative_zero = G.multi_source_shortest_paths<RadixHeap>({1, 7}, {-0.0, 3}); // taken as 0
+  expect(std::signbit(negative_zero.distance(1)) to_be false);
+  Graph::ShortestPaths positive_zero = G.multi_source_shortest_paths<RadixHeap>({1, 7}, {0, 3});
+  for (size_t n = 1; n <= 8; n++) {
+    expect(negative_zero.distance(n) to_be positive_zero.distance(n));
+  }
+
+  // single source results report their source everywhere, and a reused result forgets the origins
+  expect(from1.nearest_source(8) to_be 1);
+  expect(from1.nearest_source(99) to_be Graph::npos);
+  G.multi_source_shortest_paths({1, 7}, {}, from1);
+  expect(from1.nearest_source(6) to_be 7);
+  G.shortest_paths(7, from1);
+  expect(from1.nearest_source(1) to_be 7);
+
+  // integer weights take the bucket queue
+  BasicGraph<uint32_t, uint32_t> U = BasicGraph<uint32_t, uint32_t>::from_edges({{1, 2, 4}, {3, 2, 1}, {2, 4, 1}});
+  BasicGraph<uint32_t, uint32_t>::ShortestPaths voronoi = U.multi_source_shortest_paths({1, 3});
+  expect(voronoi.nearest_source(4) to_be 3);
+  expect(voronoi.distance(4) to_be 2);
+
+  std::cout << "end multi_source" << std::endl;
+}
+
+void reordering() {
+  std::cout << std::endl << "begin reordering" << std::endl;
+  // a path 0 - 1 - ... - 11 (both directions) hidden behind scattered IDs
+  std::vector<size_t> scattered = {70, 3, 55, 12, 91, 8, 40, 27, 66, 19, 84, 31};
+  Graph G;
+  for (size_t id : scattered) {
+    G.add_vertex(id);
+  }
+  for (size_t i = 0; i + 1 < scattered.size(); i++) {
+    G.add_edge(scattered[i], scattered[i + 1], static_cast<double>(i + 1));
+    G.add_edge(scattered[i + 1], scattered[i], static_cast<double>(i + 1));
+  }
+  G.set_coordinates(70, 1.5, 2.5);
+
+  // Cuthill-McKee walks the path from one end, so neighbours get consecutive IDs
+  VertexOrder order = cuthill_mckee_order(G);
+  expect(order.size() to_be 12);
+  Graph R = reorder(G, order);
+  expect(R.id_mode() to_be Graph::dense_ids);
+  expect(R.vertex_count() to_be 12);
+  expect(R.edge_count() to_be G.edge_count());
+  for (size_t i = 0; i + 1 < 12; i++) {
+    expect(R.contains_edge(i, i + 1) to_be true);
+  }
+  expect((order.to_original(0) == 70 || order.to_original(0) == 31) to_be true); // an end of the path
+
+  // the mapping goes both ways and the renumbered graph answers the same
+  for (size_t id : scattered) {
+    expect(order.to_original(order.to_new(id)) to_be id);
+  }
+  expect(order.to_new(5) to_be VertexOrder::npos);
+  expect(order.to_original(12) to_be VertexOrder::npos);
+  Graph::ShortestPaths before = G.shortest_paths(70);
+  Graph::ShortestPaths after = R.shortest_paths(order.to_new(70));
+  for (size_t id : scattered) {
+    expect(after.distance(order.to_new(id)) to_be before.distance(id));
+  }
+  expect(R.coordinates(order.to_new(70)).first to_be 1.5);
+  expect(R.has_coordinates(order.to_new(3)) to_be false);
+  expect(cuthill_mckee_order(G, false).to_original(0) to_be order.to_original(11)); // plain Cuthill-McKee, reversed
+
+  // disconnected pieces and isolated vertices are all placed
+  G.add_vertex(500);
+  G.add_vertex(501);
+  G.add_vertex(502);
+  G.add_edge(502, 501);
+  VertexOrder pieces = cuthill_mckee_order(G);
+  expect(pieces.size() to_be 15);
+  expect(reorder(G, pieces).edge_count() to_be G.edge_count());
+  expect_throw(reorder(G, order), std::invalid_argument); // three vertices missing
+  expect_throw(reorder(G, VertexOrder(std::vector<size_t>(15, 3))), std::invalid_argument);
+
+  // Hilbert order on a 4 x 4 grid - consecutive vertices are grid neighbours
+  Graph grid;
+  for (size_t id = 0; id < 16; id++) {
+    grid.add_vertex(id * 7); // IDs unrelated to position
+    grid.set_coordinates(id * 7, static_cast<double>(id % 4) * 10, static_cast<double>(id / 4) * 10);
+  }
+  grid.add_vertex(999); // no coordinates - goes last
+  VertexOrder curve = hilbert_order(grid);
+  expect(curve.to_original(16) to_be 999);
+  for (size_t i = 0; i + 1 < 16; i++) {
+    std::pair<double, double> a = grid.coordinates(curve.to_original(i)), b = grid.coordinates(curve.to_original(i + 1));
+    expect(std::fabs(a.first - b.first) + std::fabs(a.second - b.second) to_be 10);
+  }
+
+  std::cout << "end reordering" << std::endl;
+}
+
+// every simple path from u to dest, by DFS - reference for k_shortest_paths
+void simple_paths(const Graph& g, size_t u, size_t dest, std::vector<size_t>& path, double length, std::vector<double>& lengths) {
+  if (u == dest) {
+    lengths.push_back(length);
+    return;
+  }
+  for (size_t v = 0; v < g.vertex_count(); v++) {
+    if (!g.contains_edge(u, v) || std::find(path.begin(), path.end(), v) != path.end()) continue;
+    path.push_back(v);
+    simple_paths(g, v, dest, path, length + g.cost(u, v), lengths);
+    path.pop_back();
+  }
+}
+
+void k_shortest_paths() {
+  std::cout << std::endl << "begin k_shortest_paths" << std::endl;
+  // the usual Yen example - C D E F G H as 1 .. 6
+  Graph G;
+  for (size_t n = 1; n <= 6; n++) {
+    G.add_vertex(n);
+  }
+  G.add_edge(1, 2, 3); G.add_edge(1, 3, 2); G.add_edge(2, 4, 4); G.add_edge(3, 2, 1); G.add_edge(3, 4, 2);
+  G.add_edge(3, 5, 3); G.add_edge(4, 5, 2); G.add_edge(4, 6, 1); G.add_edge(5, 6, 2);
+
+  std::vector<Graph::Path> paths = G.k_shortest_paths(1, 6, 3);
+  expect(paths.size() to_be 3);
+  expect(paths[0].distance to_be 5);
+  expect(paths[0].vertices to_be (std::vector<size_t>{1, 3, 4, 6}));
+  expect(paths[1].distance to_be 7);
+  expect(paths[1].vertices to_be (std::vector<size_t>{1, 3, 5, 6}));
+  expect(paths[2].distance to_be 8);
+  expect(paths[2].vertices to_be (std::vector<size_t>{1, 2, 4, 6})); // ties with 1 3 2 4 6, fewer vertices first
+
+  // asking for more than exist returns them all, each once
+  paths = G.k_shortest_paths(1, 6, 100);
+  expect(paths.size() to_be 7);
+  std::set<std::vector<size_t>> distinct;
+  for (size_t i = 0; i < paths.size(); i++) {
+    distinct.insert(paths[i].vertices);
+    if (i > 0) expect((paths[i - 1].distance <= paths[i].distance) to_be true);
+  }
+  expect(distinct.size() to_be 7);
+
+  expect(G.k_shortest_paths(1, 6, 0).size() to_be 0);
+  expect(G.k_shortest_paths(6, 1, 3).size() to_be 0); // unreachable
+  expect(G.k_shortest_paths(1, 99, 3).size() to_be 0);
+  paths = G.k_shortest_paths(4, 4, 3);
+  expect(paths.size() to_be 1);
+  expect(paths[0].vertices to_be (std::vector<size_t>{4}));
+
+  // an earlier early-exit search must not leave vertices banned
+  G.shortest_paths(1, {4});
+  expect(G.k_shortest_paths(1, 6, 2)[1].distance to_be 7);
+
+  // matches brute force on random graphs, loops and cycles included
+  for (unsigned round = 0; round < 20; round++) {
+    Graph R = random_graph(11 + round, 8, 20, 9);
+    std::vector<size_t> path = {0};
+    std::vector<double> lengths;
+    simple_paths(R, 0, 7, path, 0, lengths);
+    std::sort(lengths.begin(), lengths.end());
+
+    std::vector<Graph::Path> yen = R.k_shortest_paths(0, 7, 10);
+    expect(yen.size() to_be std::min<size_t>(10, lengths.size()));
+    for (size_t i = 0; i < yen.size() && i < lengths.size(); i++) {
+      expect(yen[i].distance to_be lengths[i]);
+      std::set<size_t> unique(yen[i].vertices.begin(), yen[i].vertices.end());
+      expect(unique.size() to_be yen[i].vertices.size()); // loopless
+    }
+  }
+
+  std::cout << "end k_shortest_paths" << std::endl;
+}
+
+void negative_weights() {
+  std::cout << std::endl << "begin negative_weights" << std::endl;
+  Graph G;
+  for (size_t n = 1; n <= 5; n++) {
+    G.add_vertex(n);
+  }
+  G.add_edge(1, 2, 4); G.add_edge(1, 3, 2); G.add_edge(3, 2, -3); G.add_edge(2, 4, 2); G.add_edge(4, 5, -1); G.add_edge(3, 5, 4);
+  expect(G.has_negative_weights() to_be true);
+
+  // Dijkstra and everything built on it refuses, since it would settle vertices too early
+  expect_throw(G.shortest_paths(1), std::domain_error);
+  expect_throw(G.shortest_path(1, 5), std::domain_error);
+  expect_throw(G.bidirectional_shortest_path(1, 5), std::domain_error);
+  expect_throw(G.k_shortest_paths(1, 5, 2), std::domain_error);
+
+  // a snapshot keeps the negative weights, so the searches over it refuse it too - built, copied or mapped
+  CompactGraph frozen = G.freeze();
+  expect(frozen.has_negative_weights() to_be true);
+  expect_throw(frozen.dijkstra(0), std::domain_error);
+  CompactGraph small({0, 1, 2}, {0, 1, 2, 2}, {1, 2}, {5, -20});
+  CompactGraph copy = small;
+  expect(copy.has_negative_weights() to_be true);
+  expect_throw(DeltaStepping(small, 1, 1), std::domain_error);
+  expect_throw(ContractionHierarchy{small}, std::domain_error);
+  expect_throw(ContractionHierarchy{G}, std::domain_error);
+  small.save("negative_graph.bin");
+  CompactGraph mapped = CompactGraph::open_mapped("negative_graph.bin");
+  expect(mapped.has_negative_weights() to_be true);
+  expect_throw(mapped.dijkstra(0), std::domain_error);
+  std::remove("negative_graph.bin");
+  expect(CompactGraph({0, 1}, {0, 1, 1}, {1}, {0}).has_negative_weights() to_be false);
+
+  Graph::ShortestPaths result;
+  for (size_t threads : {size_t(1), size_t(4)}) {
+    expect(G.bellman_ford(1, result, nullptr, threads) to_be true);
+    expect(result.distance(2) to_be -1);
+    expect(result.distance(5) to_be 0);
+    expect(result.path(5) to_be (std::vector<size_t>{1, 3, 2, 4, 5}));
+    expect(result.distance(1) to_be 0);
+    G.bellman_ford(3, result, nullptr, threads);
+    expect(result.reachable(1) to_be false);
+  }
+
+  // the counter follows every way a negative weight leaves
+  G.update_weight(3, 2, 1);
+  G.remove_edge(4, 5);
+  expect(G.has_negative_weights() to_be false);
+  expect(G.shortest_paths(1).distance(4) to_be 5);
+  G.add_edge(4, 5, -1);
+  G.remove_vertex(5);
+  expect(G.has_negative_weights() to_be false);
+  expect(Graph::from_edges({{1, 2, -1}}).has_negative_weights() to_be true);
+
+  // a reachable negative cycle is reported in edge order, an unreachable one does not matter
+  Graph C;
+  for (size_t n = 0; n <= 5; n++) {
+    C.add_vertex(n);
+  }
+  C.add_edge(0, 1, 1); C.add_edge(1, 2, 1); C.add_edge(2, 3, -4); C.add_edge(3, 1, 1); C.add_edge(3, 4, 1);
+  C.add_edge(5, 0, 1);
+  for (size_t threads : {size_t(1), size_t(4)}) {
+    std::vector<size_t> cycle;
+    expect(C.bellman_ford(0, result, &cycle, threads) to_be false);
+    expect(result.reachable(4) to_be false);
+    expect(cycle.size() to_be 3);
+    double total = 0;
+    for (size_t i = 0; i < cycle.size(); i++) {
+      total += C.cost(cycle[i], cycle[(i + 1) % cycle.size()]);
+    }
+    expect(total to_be -2);
+    expect(C.bellman_ford(4, result, &cycle, threads) to_be true);
+    expect(cycle.size() to_be 0);
+  }
+
+  Johnson cyclic(C);
+  expect(cyclic.has_negative_cycle() to_be true);
+  expect(cyclic.negative_cycle().size() to_be 3);
+  expect_throw(cyclic.distance(0, 4), std::domain_error);
+  // Paths point back at their Johnson, so it stays put
+  expect(std::is_move_constructible<Johnson>::value to_be false);
+  expect(std::is_copy_assignable<Johnson>::value to_be false);
+
+  // random graphs with negative edges but no negative cycles - weights w(u, v) = c + p(v) - p(u) with c >= 0
+  // Bellman-Ford both ways, Johnson and a brute force Floyd-Warshall must agree
+  std::mt19937 rng(25);
+  for (int round = 0; round < 10; round++) {
+    const size_t n = 30;
+    std::uniform_int_distribution<int> offset(0, 20);
+    std::vector<int> p(n);
+    for (size_t v = 0; v < n; v++) {
+      p[v] = offset(rng);
+    }
+    std::vector<Graph::Edge> edges = random_edges(25 + round, n, 90, 10);
+    for (Graph::Edge& edge : edges) {
+      edge.weight += p[edge.dest] - p[edge.src];
+    }
+    std::vector<size_t> all(n);
+    for (size_t v = 0; v < n; v++) {
+      all[v] = v;
+    }
+    Graph R = Graph::from_edges(edges, all, round % 2 == 0 ? Graph::sparse_ids : Graph::dense_ids);
+
+    std::vector<std::vector<double>> floyd(n, std::vector<double>(n, INFINITY));
+    for (size_t u = 0; u < n; u++) {
+      floyd[u][u] = 0;
+      for (size_t v = 0; v < n; v++) {
+        if (R.contains_edge(u, v)) floyd[u][v] = std::min(floyd[u][v], R.cost(u, v));
+      }
+    }
+    for (size_t k = 0; k < n; k++) {
+      for (size_t u = 0; u < n; u++) {
+        for (size_t v = 0; v < n; v++) {
+          floyd[u][v] = std::min(floyd[u][v], floyd[u][k] + floyd[k][v]);
+        }
+      }
+    }
+
+    Johnson J(R, round % 3);
+    expect(J.has_negative_cycle() to_be false);
+    std::vector<double> matrix(n * n);
+    J.distance_matrix(all, all, matrix.data(), 2);
+
+    // reweighting may round - equal up to 1e-9, or both unreachable
+    auto close = [](double a, double b) { return a == b || std::abs(a - b) < 1e-9; };
+    bool agree = true;
+    Graph::ShortestPaths parallel;
+    for (size_t u = 0; u < n; u++) {
+      R.bellman_ford(u, result);
+      R.bellman_ford(u, parallel, nullptr, 3);
+      Johnson::Paths paths = J.shortest_paths(u);
+      for (size_t v = 0; v < n; v++) {
+        agree = agree && result.distance(v) == floyd[u][v] && parallel.distance(v) == floyd[u][v];
+        agree = agree && close(paths.distance(v), floyd[u][v]) && close(matrix[u * n + v], floyd[u][v]);
+        if (floyd[u][v] != INFINITY) {
+          std::vector<size_t> path = paths.path(v);
+          double length = 0;
+          for (size_t i = 1; i < path.size(); i++) {
+            length += R.cost(path[i - 1], path[i]);
+          }
+          agree = agree && close(length, floyd[u][v]);
+        }
+      }
+    }
+    expect(agree to_be true);
+    expect(close(J.distance(0, n - 1), floyd[0][n - 1]) to_be true);
+    expect(J.path(0, n - 1).empty() to_be (floyd[0][n - 1] == INFINITY));
+  }
+
+  std::cout << "end negative_weights" << std::endl;
+}
+
 int main() {
 
   compile_test();
@@ -516,6 +2291,30 @@ int main() {
   // rule_of_three(); // requires that internal data members are public for access - will not compile when private
   dijkstra();
   // internal_dijkstra(); // requires that internal data members are public for access - will not compile when private
+  compact_graph();
+  const_shortest_paths();
+  early_exit_shortest_paths();
+  pluggable_queues();
+  bidirectional();
+  astar();
+  contraction_hierarchy();
+  delta_stepping();
+  distance_matrix();
+  arena_storage();
+  vertex_removal();
+  bulk_construction();
+  mapped_format();
+  graph_readers();
+  dynamic_shortest_paths();
+  path_cache();
+  search_stats();
+  templated_graph();
+  dense_ids();
+  move_and_share();
+  multi_source();
+  reordering();
+  k_shortest_paths();
+  negative_weights();
     
   return 0;
 }
@@ -0,0 +1,81 @@
+#include "graph.h"
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <string>
+
+// compares the priority queues in heaps.h on Graph::shortest_paths - `make heap_bench`
+
+Graph random_graph(size_t vertices, size_t edges, bool integer_weights) {
+    std::mt19937_64 rng(42);
+    std::uniform_int_distribution<size_t> vertex(0, vertices - 1);
+    std::uniform_real_distribution<double> weight(1, 100);
+    Graph g;
+    for (size_t n = 0; n < vertices; n++) {
+        g.add_vertex(n);
+    }
+    while (g.edge_count() < edges) {
+        double w = weight(rng);
+        g.add_edge(vertex(rng), vertex(rng), integer_weights ? std::floor(w) : w);
+    }
+    return g;
+}
+
+Graph grid_graph(size_t side, bool integer_weights) {
+    // 4-neighbour grid with edges in both directions, the usual stand-in for road networks
+    std::mt19937_64 rng(42);
+    std::uniform_real_distribution<double> weight(1, 100);
+    Graph g;
+    for (size_t n = 0; n < side * side; n++) {
+        g.add_vertex(n);
+    }
+    for (size_t r = 0; r < side; r++) {
+        for (size_t c = 0; c < side; c++) {
+            size_t n = r * side + c;
+            double w = weight(rng);
+            if (integer_weights) w = std::floor(w);
+            if (c + 1 < side) { g.add_edge(n, n + 1, w); g.add_edge(n + 1, n, w); }
+            if (r + 1 < side) { g.add_edge(n, n + side, w); g.add_edge(n + side, n, w); }
+        }
+    }
+    return g;
+}
+
+template <class Queue>
+void run(const std::string& graph_name, const std::string& queue_name, const Graph& g, size_t queries) {
+    Graph::ShortestPaths result;
+    double checksum = 0;
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (size_t q = 0; q < queries; q++) {
+        size_t src = (q * 7919) % g.vertex_count();
+        g.shortest_paths<Queue>(src, result);
+        double d = result.distance((src + 1) % g.vertex_count());
+        if (d != INFINITY) checksum += d; // keeps the work observable
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << graph_name << "," << queue_name << "," << g.vertex_count() << "," << g.edge_count() << ","
+              << elapsed.count() / queries << "," << checksum << std::endl;
+}
+
+template <class Queue>
+void run_all(const std::string& queue_name, const Graph& random_real, const Graph& random_int, const Graph& grid_real, const Graph& grid_int) {
+    run<Queue>("random_real", queue_name, random_real, 10);
+    run<Queue>("random_int", queue_name, random_int, 10);
+    run<Queue>("grid_real", queue_name, grid_real, 10);
+    run<Queue>("grid_int", queue_name, grid_int, 10);
+}
+
+int main() {
+    Graph random_real = random_graph(100000, 400000, false);
+    Graph random_int = random_graph(100000, 400000, true);
+    Graph grid_real = grid_graph(300, false);
+    Graph grid_int = grid_graph(300, true);
+
+    std::cout << "graph,queue,vertices,edges,ms_per_query,checksum" << std::endl;
+    run_all<BinaryHeap>("binary_lazy", random_real, random_int, grid_real, grid_int);
+    run_all<DaryHeap<2>>("dary2_indexed", random_real, random_int, grid_real, grid_int);
+    run_all<DaryHeap<4>>("dary4_indexed", random_real, random_int, grid_real, grid_int);
+    run_all<DaryHeap<8>>("dary8_indexed", random_real, random_int, grid_real, grid_int);
+    run_all<RadixHeap>("radix", random_real, random_int, grid_real, grid_int);
+    return 0;
+}
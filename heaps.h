@@ -0,0 +1,201 @@
+/*
+*   Priority queues for the shortest path searches in graph.h
+*   Items are dense vertex slots in [0, capacity) and keys are tentative distances. Every queue supports
+*       clear(capacity)   empty the queue and accept items below capacity
+*       empty()
+*       push(item, key)   insert item, or lower its key if the queue tracks queued items
+*       pop()             remove and return the (key, item) pair with the smallest key
+*   Lazy queues (BinaryHeap, RadixHeap) may hand back an item more than once - callers skip stale pairs
+*/
+
+#pragma once
+#include <vector>
+#include <utility> // pair
+#include <algorithm> // push_heap, pop_heap
+#include <functional> // greater
+#include <cstdint> // uint64_t
+#include <cstring> // memcpy
+
+// std::push_heap/pop_heap with lazy deletion - every improvement adds an entry, so it grows to O(E)
+class BinaryHeap {
+    std::vector<std::pair<double, size_t>> heap;
+
+    public:
+    BinaryHeap() : heap{} {}
+
+    void clear(size_t) { heap.clear(); }
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+
+    void push(size_t item, double key) {
+        heap.push_back(std::pair<double, size_t>(key, item));
+        std::push_heap(heap.begin(), heap.end(), std::greater<std::pair<double, size_t>>());
+    }
+
+    std::pair<double, size_t> pop() {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<std::pair<double, size_t>>());
+        std::pair<double, size_t> top = heap.back();
+        heap.pop_back();
+        return top;
+    }
+};
+
+// indexed d-ary heap with true decrease-key - holds each item at most once, so it never exceeds O(V)
+template <size_t Arity = 4>
+class DaryHeap {
+    static_assert(Arity >= 2, "DaryHeap needs at least two children per node");
+    static constexpr size_t npos = static_cast<size_t>(-1);
+
+    std::vector<std::pair<double, size_t>> heap;
+    std::vector<size_t> position; // item -> index in heap, npos when not queued
+
+    public:
+    DaryHeap() : heap{}, position{} {}
+
+    void clear(size_t capacity) {
+        // only the items still queued have a position to forget - keeps clear() O(size) instead of O(capacity)
+        for (const std::pair<double, size_t>& entry : heap) {
+            position[entry.second] = npos;
+        }
+        heap.clear();
+        if (position.size() < capacity) position.resize(capacity, npos);
+    }
+
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+
+    void push(size_t item, double key) {
+        size_t index = position[item];
+        if (index == npos) {
+            index = heap.size();
+            heap.push_back(std::pair<double, size_t>(key, item));
+        } else if (key < heap[index].first) {
+            heap[index].first = key;
+        } else {
+            return; // not a decrease
+        }
+        sift_up(index);
+    }
+
+    std::pair<double, size_t> pop() {
+        std::pair<double, size_t> top = heap.front();
+        position[top.second] = npos;
+
+        std::pair<double, size_t> last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            heap.front() = last;
+            position[last.second] = 0;
+            sift_down(0);
+        }
+        return top;
+    }
+
+    private:
+    void sift_up(size_t index) {
+        std::pair<double, size_t> entry = heap[index];
+        while (index > 0) {
+            size_t parent = (index - 1) / Arity;
+            if (heap[parent].first <= entry.first) break;
+            heap[index] = heap[parent];
+            position[heap[index].second] = index;
+            index = parent;
+        }
+        heap[index] = entry;
+        position[entry.second] = index;
+    }
+
+    void sift_down(size_t index) {
+        std::pair<double, size_t> entry = heap[index];
+        for (;;) {
+            size_t first = index * Arity + 1;
+            if (first >= heap.size()) break;
+
+            // smallest child
+            size_t last = std::min(first + Arity, heap.size());
+            size_t best = first;
+            for (size_t child = first + 1; child < last; child++) {
+                if (heap[child].first < heap[best].first) best = child;
+            }
+
+            if (entry.first <= heap[best].first) break;
+            heap[index] = heap[best];
+            position[heap[index].second] = index;
+            index = best;
+        }
+        heap[index] = entry;
+        position[entry.second] = index;
+    }
+};
+
+// monotone radix heap - keys must be non-negative and never below the last popped key (dijkstra with
+// non-negative weights). Works on the IEEE bit pattern, which orders non-negative doubles like integers,
+// so integer and quantized weights need no conversion. Amortized O(log C) per item with 65 buckets.
+class RadixHeap {
+    static constexpr size_t buckets = 65;
+
+    std::vector<std::pair<uint64_t, size_t>> bucket[buckets];
+    uint64_t last; // bits of the last popped key
+    size_t count;
+
+    static uint64_t bits(double key) {
+        uint64_t b;
+        std::memcpy(&b, &key, sizeof b);
+        return b;
+    }
+
+    static double key_of(uint64_t b) {
+        double key;
+        std::memcpy(&key, &b, sizeof key);
+        return key;
+    }
+
+    // bucket 0 holds keys equal to last, bucket i holds keys whose highest bit differing from last is i - 1
+    size_t bucket_of(uint64_t b) const {
+        return b == last ? 0 : 64 - static_cast<size_t>(__builtin_clzll(b ^ last));
+    }
+
+    public:
+    RadixHeap() : bucket{}, last{0}, count{0} {}
+
+    void clear(size_t) {
+        for (std::vector<std::pair<uint64_t, size_t>>& b : bucket) {
+            b.clear();
+        }
+        last = 0;
+        count = 0;
+    }
+
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+
+    void push(size_t item, double key) {
+        uint64_t b = bits(key);
+        bucket[bucket_of(b)].push_back(std::pair<uint64_t, size_t>(b, item));
+        count++;
+    }
+
+    std::pair<double, size_t> pop() {
+        if (bucket[0].empty()) {
+            // move up to the smallest non-empty bucket and spread it over the lower buckets
+            size_t i = 1;
+            while (bucket[i].empty()) i++;
+
+            uint64_t smallest = bucket[i].front().first;
+            for (const std::pair<uint64_t, size_t>& entry : bucket[i]) {
+                smallest = std::min(smallest, entry.first);
+            }
+            last = smallest;
+
+            for (const std::pair<uint64_t, size_t>& entry : bucket[i]) {
+                bucket[bucket_of(entry.first)].push_back(entry);
+            }
+            bucket[i].clear();
+        }
+
+        std::pair<uint64_t, size_t> top = bucket[0].back();
+        bucket[0].pop_back();
+        count--;
+        return std::pair<double, size_t>(key_of(top.first), top.second);
+    }
+};
@@ -0,0 +1,144 @@
+/*
+*   All pairs shortest paths on graphs with negative edge weights (Johnson's reweighting)
+*   One multi-source Bellman-Ford run gives every vertex a potential h - its distance from a virtual source with a
+*   zero weight edge to every vertex. Reweighting each edge u -> v to w + h(u) - h(v) makes every weight non-negative
+*   and shifts every u -> v path by the same h(u) - h(v), so after that one-off pass each source costs a single
+*   Dijkstra on the reweighted copy - instead of a Bellman-Ford run per source - and distances are shifted back.
+*   Built from a snapshot: changes to the graph afterwards are not seen. Paths point back at the Johnson that made
+*   them for the potentials, so a Johnson is neither copied nor moved and must outlive its Paths.
+*/
+
+#pragma once
+#include "graph.h"
+#include "compact_graph.h"
+#include <vector>
+#include <unordered_map>
+#include <algorithm> // max
+#include <cmath> // INFINITY
+#include <stdexcept> // domain_error
+
+class Johnson {
+    Graph reweighted;                              // same vertices and edges, weights made non-negative
+    std::unordered_map<size_t, double> potentials; // vertex ID -> h
+    std::vector<size_t> cycle;                     // a negative cycle of the graph, empty when there is none
+
+    public:
+    // answers of one source - distances on the original weights
+    class Paths {
+        friend class Johnson;
+        const Johnson* owner; // potentials of the other end
+        double shift; // h of the source
+        Graph::ShortestPaths reduced;
+
+        public:
+        Paths() : owner{nullptr}, shift{0}, reduced{} {}
+        Paths(const Paths&) = default;
+        Paths& operator=(const Paths&) = default;
+
+        size_t source() const { return reduced.source(); }
+
+        bool reachable(size_t id) const { return reduced.reachable(id); }
+
+        // exact distance to id, INFINITY when id is unreachable
+        double distance(size_t id) const {
+            double d = reduced.distance(id);
+            return d == INFINITY ? INFINITY : d - shift + owner->potential(id);
+        }
+
+        // vertex IDs from the source to id inclusive, empty when id is unreachable - reweighting keeps the paths
+        std::vector<size_t> path(size_t id) const { return reduced.path(id); }
+    };
+
+    // runs Bellman-Ford over the whole graph on threads threads (see Graph::bellman_ford) and builds the reweighted copy
+    explicit Johnson(const Graph& g, size_t threads = 1) : reweighted{g.id_mode()}, potentials{}, cycle{} {
+        CompactGraph c = g.freeze();
+        std::vector<size_t> ids(c.vertex_count());
+        for (size_t i = 0; i < ids.size(); i++) {
+            ids[i] = c.id_of(i);
+        }
+
+        Graph::ShortestPaths result;
+        if (!g.bellman_ford(ids, result, &cycle, threads)) return;
+
+        std::vector<double> h(ids.size());
+        potentials.reserve(ids.size());
+        for (size_t i = 0; i < ids.size(); i++) {
+            h[i] = result.distance(ids[i]);
+            potentials.insert(std::pair<size_t, double>(ids[i], h[i]));
+        }
+
+        // rounding can leave a tight edge a hair below zero - clamp it, the error is far below the weights' precision
+        std::vector<Graph::Edge> edge_list;
+        edge_list.reserve(c.edge_count());
+        for (size_t u = 0; u < c.vertex_count(); u++) {
+            for (size_t e = c.edges_begin(u); e < c.edges_end(u); e++) {
+                double weight = std::max(0.0, c.weight(e) + h[u] - h[c.target(e)]);
+                edge_list.push_back(Graph::Edge{ids[u], ids[c.target(e)], weight});
+            }
+        }
+        reweighted = Graph::from_edges(std::move(edge_list), ids, g.id_mode());
+    }
+
+    Johnson(const Johnson&) = delete;
+    Johnson& operator=(const Johnson&) = delete;
+
+    bool has_negative_cycle() const { return !cycle.empty(); }
+
+    // vertex IDs of a negative cycle in edge order, empty when there is none - shortest paths are then undefined
+    const std::vector<size_t>& negative_cycle() const { return cycle; }
+
+    // h of a vertex, 0 for unknown vertices
+    double potential(size_t id) const {
+        std::unordered_map<size_t, double>::const_iterator it = potentials.find(id);
+        return it == potentials.end() ? 0 : it->second;
+    }
+
+    // queries - each one Dijkstra on the reweighted copy; all throw domain_error when the graph has a negative cycle
+    Paths shortest_paths(size_t src) const {
+        Paths paths;
+        shortest_paths(src, paths);
+        return paths;
+    }
+
+    void shortest_paths(size_t src, Paths& paths) const {
+        require_no_cycle();
+        paths.owner = this;
+        paths.shift = potential(src);
+        reweighted.shortest_paths(src, paths.reduced);
+    }
+
+    double distance(size_t src, size_t dest) const {
+        require_no_cycle();
+        std::vector<size_t> target{dest};
+        double d = reweighted.shortest_paths(src, target).distance(dest);
+        return d == INFINITY ? INFINITY : d - potential(src) + potential(dest);
+    }
+
+    std::vector<size_t> path(size_t src, size_t dest) const {
+        require_no_cycle();
+        return reweighted.shortest_path(src, dest);
+    }
+
+    // same layout and threading as Graph::distance_matrix
+    void distance_matrix(const std::vector<size_t>& sources, const std::vector<size_t>& targets, double* out, size_t threads = 0) const {
+        require_no_cycle();
+        reweighted.distance_matrix(sources, targets, out, threads);
+
+        std::vector<double> target_shift(targets.size());
+        for (size_t j = 0; j < targets.size(); j++) {
+            target_shift[j] = potential(targets[j]);
+        }
+        for (size_t i = 0; i < sources.size(); i++) {
+            double source_shift = potential(sources[i]);
+            double* row = out + i * targets.size();
+            for (size_t j = 0; j < targets.size(); j++) {
+                if (row[j] != INFINITY) row[j] += target_shift[j] - source_shift;
+            }
+        }
+    }
+
+    private:
+    void require_no_cycle() const {
+        if (has_negative_cycle()) throw std::domain_error("Johnson: the graph has a negative cycle");
+    }
+};
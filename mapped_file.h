@@ -0,0 +1,52 @@
+/*
+*   Read-only memory mapping of a whole file (POSIX mmap)
+*   A shared, read-only mapping (MAP_SHARED, PROT_READ) that reads straight from the page cache, so opening a file
+*   is O(1), pages are faulted in on first touch and processes mapping the same file share its pages. The file may be
+*   closed or even unlinked once it is mapped; changes to it made in place afterwards show through.
+*/
+
+#pragma once
+#include <string>
+#include <stdexcept> // runtime_error
+#include <sys/mman.h> // mmap, munmap
+#include <sys/stat.h> // fstat
+#include <fcntl.h> // open
+#include <unistd.h> // close
+
+class MappedFile {
+    const char* bytes;
+    size_t length;
+
+    public:
+    explicit MappedFile(const std::string& path) : bytes{nullptr}, length{0} {
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("MappedFile: cannot open " + path);
+
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("MappedFile: cannot stat " + path);
+        }
+        length = static_cast<size_t>(info.st_size);
+
+        if (length > 0) { // mmap rejects empty mappings, an empty file is just an empty view
+            void* p = ::mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("MappedFile: cannot map " + path);
+            }
+            bytes = static_cast<const char*>(p);
+        }
+        ::close(fd); // the mapping keeps its own reference to the file
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile() {
+        if (bytes != nullptr) ::munmap(const_cast<char*>(bytes), length);
+    }
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+};
@@ -0,0 +1,131 @@
+/*
+*   Minimal fork-join helpers for the batched queries and the parallel searches
+*   Items are handed out one at a time through an atomic counter so uneven searches balance themselves;
+*   the calling thread works too, so threads == 1 never starts a thread
+*     - parallel_for starts its threads per call, fine for a few long loops
+*     - WorkerPool keeps them for its lifetime, for searches that run many short rounds
+*/
+
+#pragma once
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm> // min, max
+
+// 0 means every hardware thread
+inline size_t resolve_threads(size_t threads) {
+    return threads > 0 ? threads : std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+// calls f(i) for every i in [0, count), spread over up to threads threads
+template <class Function>
+void parallel_for(size_t count, size_t threads, Function f) {
+    std::atomic<size_t> next(0);
+    auto work = [&next, &f, count]() {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            f(i);
+        }
+    };
+
+    size_t workers = std::min(resolve_threads(threads), count);
+    std::vector<std::thread> pool;
+    for (size_t t = 1; t < workers; t++) {
+        pool.emplace_back(work);
+    }
+    work();
+    for (std::thread& worker : pool) {
+        worker.join();
+    }
+}
+
+// threads - 1 workers that sleep between rounds; run() hands each round to them instead of starting threads - one caller at a time
+class WorkerPool {
+    std::vector<std::thread> workers;
+    std::mutex lock;
+    std::condition_variable wake; // a round started, or the pool is stopping
+    std::condition_variable done; // the last worker left the round
+    std::function<void(size_t)> task;
+    size_t count;
+    std::atomic<size_t> next;
+    size_t generation; // rounds started so far
+    size_t busy;       // workers still in the current round
+    bool stopping;
+
+    public:
+    explicit WorkerPool(size_t threads = 0)
+        : workers{}, lock{}, wake{}, done{}, task{}, count{0}, next(0), generation{0}, busy{0}, stopping{false} {
+        for (size_t t = 1; t < resolve_threads(threads); t++) {
+            workers.emplace_back([this]() { serve(); });
+        }
+    }
+
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    ~WorkerPool() {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // threads taking part in a round, the caller included
+    size_t size() const { return workers.size() + 1; }
+
+    // calls f(i) for every i in [0, items) and returns once all calls are done
+    template <class Function>
+    void run(size_t items, Function f) {
+        if (workers.empty() || items <= 1) {
+            for (size_t i = 0; i < items; i++) {
+                f(i);
+            }
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            task = [&f](size_t i) { f(i); };
+            count = items;
+            next.store(0);
+            busy = workers.size();
+            generation++;
+        }
+        wake.notify_all();
+        work();
+
+        std::unique_lock<std::mutex> guard(lock);
+        done.wait(guard, [this]() { return busy == 0; });
+        task = nullptr;
+    }
+
+    private:
+    // task and count only change under the lock while no round is running, so reading them here is safe
+    void work() {
+        for (size_t i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+            task(i);
+        }
+    }
+
+    void serve() {
+        size_t seen = 0;
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                wake.wait(guard, [this, &seen]() { return stopping || generation != seen; });
+                if (stopping) return;
+                seen = generation;
+            }
+            work();
+
+            std::lock_guard<std::mutex> guard(lock);
+            if (--busy == 0) done.notify_one();
+        }
+    }
+};
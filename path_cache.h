@@ -0,0 +1,126 @@
+/*
+*   LRU cache of single source shortest path results for a Graph
+*   Results are kept per source up to a memory budget, least recently used first out. Every entry belongs to
+*   the Graph::version() it was computed at; the first lookup after the graph changes drops them all.
+*   Lookups may come from several threads - results are computed outside the lock and shared read-only.
+*/
+
+#pragma once
+#include "graph.h"
+#include <list>
+#include <unordered_map>
+#include <memory> // shared_ptr
+#include <mutex>
+
+class ShortestPathCache {
+    public:
+    struct Stats {
+        size_t hits;
+        size_t misses;
+        size_t evictions;     // entries dropped to stay within the budget
+        size_t invalidations; // entries dropped because the graph changed
+    };
+
+    typedef std::shared_ptr<const Graph::ShortestPaths> Result;
+
+    private:
+    struct Entry {
+        size_t src;
+        Result result;
+        size_t bytes;
+    };
+
+    const Graph& g;
+    size_t budget;
+    size_t used;
+    size_t version; // graph version of every entry
+    std::list<Entry> order; // most recently used first
+    std::unordered_map<size_t, std::list<Entry>::iterator> entries; // source -> its place in order
+    Stats counters;
+    mutable std::mutex lock;
+
+    public:
+    ShortestPathCache(const Graph& g, size_t budget_bytes)
+        : g{g}, budget{budget_bytes}, used{0}, version{g.version()}, order{}, entries{}, counters{0, 0, 0, 0}, lock{} {}
+
+    ShortestPathCache(const ShortestPathCache&) = delete;
+    ShortestPathCache& operator=(const ShortestPathCache&) = delete;
+
+    // shortest paths from src, computed on a miss - the result stays valid after eviction while it is held
+    Result get(size_t src) {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            revalidate();
+            std::unordered_map<size_t, std::list<Entry>::iterator>::iterator found = entries.find(src);
+            if (found != entries.end()) {
+                counters.hits++;
+                order.splice(order.begin(), order, found->second);
+                return found->second->result;
+            }
+            counters.misses++;
+        }
+
+        std::shared_ptr<Graph::ShortestPaths> computed = std::make_shared<Graph::ShortestPaths>();
+        size_t computed_at = g.version();
+        g.shortest_paths(src, *computed);
+        Result result = computed;
+
+        std::lock_guard<std::mutex> guard(lock);
+        revalidate();
+        if (computed_at != version || entries.count(src)) return result; // stale already, or another thread won
+        insert(src, result, computed->memory_bytes() + sizeof(Entry));
+        return result;
+    }
+
+    double distance(size_t src, size_t dest) { return get(src)->distance(dest); }
+    std::vector<size_t> path(size_t src, size_t dest) { return get(src)->path(dest); }
+
+    Stats stats() const {
+        std::lock_guard<std::mutex> guard(lock);
+        return counters;
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> guard(lock);
+        return entries.size();
+    }
+
+    size_t bytes_used() const {
+        std::lock_guard<std::mutex> guard(lock);
+        return used;
+    }
+
+    size_t budget_bytes() const { return budget; }
+
+    void clear() {
+        std::lock_guard<std::mutex> guard(lock);
+        order.clear();
+        entries.clear();
+        used = 0;
+    }
+
+    private:
+    // drops everything computed before the graph last changed - lock held
+    void revalidate() {
+        if (version == g.version()) return;
+        counters.invalidations += entries.size();
+        order.clear();
+        entries.clear();
+        used = 0;
+        version = g.version();
+    }
+
+    // lock held
+    void insert(size_t src, const Result& result, size_t bytes) {
+        if (bytes > budget) return; // would evict everything and still not fit
+        while (used + bytes > budget) {
+            used -= order.back().bytes;
+            entries.erase(order.back().src);
+            order.pop_back();
+            counters.evictions++;
+        }
+        order.push_front(Entry{src, result, bytes});
+        entries.insert(std::pair<size_t, std::list<Entry>::iterator>(src, order.begin()));
+        used += bytes;
+    }
+};
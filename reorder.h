@@ -0,0 +1,226 @@
+/*
+*   Vertex reordering for cache locality
+*   Renumbers a graph's vertices 0..V-1 so that vertices close in the graph get close IDs - and with them close
+*   slots, arena blocks and result array entries - which cuts the cache misses of every search on large sparse graphs.
+*     - cuthill_mckee_order: breadth first from a peripheral vertex of each component, neighbours by ascending degree,
+*       reversed by default (reverse Cuthill-McKee); needs only the edges, directions are ignored
+*     - hilbert_order: position along a Hilbert curve over the vertex coordinates (set_coordinates), for road graphs
+*   reorder() builds the renumbered graph; the VertexOrder maps between new and original IDs in both directions.
+*/
+
+#pragma once
+#include "graph.h"
+#include "compact_graph.h"
+#include <vector>
+#include <unordered_map>
+#include <algorithm> // sort, stable_sort, reverse
+#include <cstdint> // uint64_t
+#include <utility> // pair
+#include <stdexcept> // invalid_argument
+
+class VertexOrder {
+    std::vector<size_t> originals;                 // new ID -> original ID
+    std::unordered_map<size_t, size_t> renumbered; // original ID -> new ID
+
+    public:
+    static constexpr size_t npos = Graph::npos;
+
+    VertexOrder() : originals{}, renumbered{} {}
+
+    // original IDs in their new order - must name every vertex of the graph once
+    explicit VertexOrder(std::vector<size_t> order) : originals{std::move(order)}, renumbered{} {
+        renumbered.reserve(originals.size());
+        for (size_t i = 0; i < originals.size(); i++) {
+            renumbered.insert(std::pair<size_t, size_t>(originals[i], i));
+        }
+    }
+
+    size_t size() const { return originals.size(); }
+
+    // new ID of an original ID, npos when it is not part of the order
+    size_t to_new(size_t original) const {
+        std::unordered_map<size_t, size_t>::const_iterator it = renumbered.find(original);
+        return it == renumbered.end() ? npos : it->second;
+    }
+
+    // original ID of a new ID, npos when out of range
+    size_t to_original(size_t renumbered_id) const {
+        return renumbered_id < originals.size() ? originals[renumbered_id] : npos;
+    }
+
+    const std::vector<size_t>& originals_by_new_id() const { return originals; }
+};
+
+// (reverse) Cuthill-McKee order of the vertices of a frozen graph, treating every edge as undirected
+inline VertexOrder cuthill_mckee_order(const CompactGraph& c, bool reverse = true) {
+    size_t n = c.vertex_count();
+
+    // symmetric adjacency in CSR form - out edges plus reversed in edges, parallel pairs count once per direction
+    std::vector<size_t> offsets(n + 1, 0);
+    for (size_t u = 0; u < n; u++) {
+        for (size_t e = c.edges_begin(u); e < c.edges_end(u); e++) {
+            offsets[u + 1]++;
+            offsets[c.target(e) + 1]++;
+        }
+    }
+    for (size_t u = 0; u < n; u++) {
+        offsets[u + 1] += offsets[u];
+    }
+    std::vector<size_t> neighbours(offsets[n]);
+    std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+    for (size_t u = 0; u < n; u++) {
+        for (size_t e = c.edges_begin(u); e < c.edges_end(u); e++) {
+            neighbours[fill[u]++] = c.target(e);
+            neighbours[fill[c.target(e)]++] = u;
+        }
+    }
+    std::vector<size_t> degree(n);
+    for (size_t u = 0; u < n; u++) {
+        degree[u] = offsets[u + 1] - offsets[u];
+    }
+
+    // breadth first from start over unplaced vertices, each vertex's new neighbours in ascending degree order
+    // appends to order and returns the first vertex of the last level
+    std::vector<bool> placed(n, false);
+    std::vector<size_t> order;
+    order.reserve(n);
+    auto bfs = [&](size_t start) {
+        size_t first = order.size();
+        order.push_back(start);
+        placed[start] = true;
+        size_t level_end = order.size(), last_level = first;
+        for (size_t i = first; i < order.size(); i++) {
+            if (i == level_end) {
+                last_level = i;
+                level_end = order.size();
+            }
+            size_t u = order[i];
+            size_t before = order.size();
+            for (size_t k = offsets[u]; k < offsets[u + 1]; k++) {
+                if (!placed[neighbours[k]]) {
+                    placed[neighbours[k]] = true;
+                    order.push_back(neighbours[k]);
+                }
+            }
+            std::sort(order.begin() + static_cast<std::ptrdiff_t>(before), order.end(), [&degree](size_t a, size_t b) {
+                return degree[a] < degree[b] || (degree[a] == degree[b] && a < b);
+            });
+        }
+        return order[last_level];
+    };
+
+    // components in order of their lowest degree vertex; each starts from a pseudo-peripheral vertex - the last level of a trial
+    // breadth first search from the component's lowest degree vertex (George-Liu, one round)
+    std::vector<size_t> by_degree(n);
+    for (size_t u = 0; u < n; u++) {
+        by_degree[u] = u;
+    }
+    std::stable_sort(by_degree.begin(), by_degree.end(), [&degree](size_t a, size_t b) { return degree[a] < degree[b]; });
+    for (size_t seed : by_degree) {
+        if (placed[seed]) continue;
+        size_t first = order.size();
+        size_t far = bfs(seed);
+        for (size_t i = first; i < order.size(); i++) {
+            placed[order[i]] = false;
+        }
+        order.resize(first);
+        bfs(far);
+    }
+    if (reverse) std::reverse(order.begin(), order.end());
+
+    std::vector<size_t> originals(n);
+    for (size_t i = 0; i < n; i++) {
+        originals[i] = c.id_of(order[i]);
+    }
+    return VertexOrder(std::move(originals));
+}
+
+inline VertexOrder cuthill_mckee_order(const Graph& g, bool reverse = true) { return cuthill_mckee_order(g.freeze(), reverse); }
+
+// distance of (x, y) along a Hilbert curve filling a side x side grid, side a power of two
+inline uint64_t hilbert_index(uint64_t side, uint64_t x, uint64_t y) {
+    uint64_t d = 0;
+    for (uint64_t s = side / 2; s > 0; s /= 2) {
+        uint64_t rx = (x & s) > 0;
+        uint64_t ry = (y & s) > 0;
+        d += s * s * ((3 * rx) ^ ry);
+        if (ry == 0) { // rotate the quadrant
+            if (rx == 1) {
+                x = side - 1 - x;
+                y = side - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+// vertices along a Hilbert curve over their coordinates; vertices without coordinates follow in ascending ID order
+inline VertexOrder hilbert_order(const Graph& g) {
+    static constexpr uint64_t side = uint64_t(1) << 16;
+
+    CompactGraph c = g.freeze(); // only for the sorted vertex IDs
+    double min_x = INFINITY, min_y = INFINITY, max_x = -INFINITY, max_y = -INFINITY;
+    for (size_t i = 0; i < c.vertex_count(); i++) {
+        if (!g.has_coordinates(c.id_of(i))) continue;
+        std::pair<double, double> at = g.coordinates(c.id_of(i));
+        min_x = std::min(min_x, at.first);
+        max_x = std::max(max_x, at.first);
+        min_y = std::min(min_y, at.second);
+        max_y = std::max(max_y, at.second);
+    }
+    double span = std::max(max_x - min_x, max_y - min_y);
+    double scale = span > 0 ? static_cast<double>(side - 1) / span : 0; // same scale on both axes keeps the curve's shape
+
+    std::vector<std::pair<uint64_t, size_t>> keyed; // (curve position, ID) - unlocated vertices sort after every position
+    keyed.reserve(c.vertex_count());
+    for (size_t i = 0; i < c.vertex_count(); i++) {
+        size_t id = c.id_of(i);
+        if (!g.has_coordinates(id)) {
+            keyed.push_back(std::pair<uint64_t, size_t>(side * side, id));
+            continue;
+        }
+        std::pair<double, double> at = g.coordinates(id);
+        uint64_t x = static_cast<uint64_t>((at.first - min_x) * scale);
+        uint64_t y = static_cast<uint64_t>((at.second - min_y) * scale);
+        keyed.push_back(std::pair<uint64_t, size_t>(hilbert_index(side, x, y), id));
+    }
+    std::sort(keyed.begin(), keyed.end());
+
+    std::vector<size_t> originals(keyed.size());
+    for (size_t i = 0; i < keyed.size(); i++) {
+        originals[i] = keyed[i].second;
+    }
+    return VertexOrder(std::move(originals));
+}
+
+// copy of g with vertex order.to_original(i) renamed to i, coordinates included - dense IDs by default
+inline Graph reorder(const Graph& g, const VertexOrder& order, Graph::IdMode mode = Graph::dense_ids) {
+    if (order.size() != g.vertex_count()) throw std::invalid_argument("reorder: the order must name every vertex once");
+
+    CompactGraph c = g.freeze();
+    std::vector<size_t> renumbered(c.vertex_count()); // dense index in c -> new ID
+    for (size_t i = 0; i < c.vertex_count(); i++) {
+        renumbered[i] = order.to_new(c.id_of(i));
+        if (renumbered[i] == VertexOrder::npos) throw std::invalid_argument("reorder: the order must name every vertex once");
+    }
+
+    std::vector<Graph::Edge> edges;
+    edges.reserve(c.edge_count());
+    for (size_t u = 0; u < c.vertex_count(); u++) {
+        for (size_t e = c.edges_begin(u); e < c.edges_end(u); e++) {
+            edges.push_back(Graph::Edge{renumbered[u], renumbered[c.target(e)], c.weight(e)});
+        }
+    }
+    std::vector<size_t> ids(order.size());
+    for (size_t i = 0; i < ids.size(); i++) {
+        ids[i] = i;
+    }
+
+    Graph result = Graph::from_edges(std::move(edges), ids, mode);
+    for (size_t i = 0; i < c.vertex_count(); i++) {
+        size_t id = c.id_of(i);
+        if (g.has_coordinates(id)) result.set_coordinates(renumbered[i], g.coordinates(id).first, g.coordinates(id).second);
+    }
+    return result;
+}
@@ -0,0 +1,98 @@
+#include "graph.h"
+#include "reorder.h"
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cmath> // sqrt
+
+// Dijkstra latency on a road-like grid before and after vertex reordering - `make reorder_bench`
+// usage: ./reorder_bench [vertices] - default 1e6
+// the grid's IDs are shuffled first, as IDs from a real import would be; every graph uses dense IDs
+
+typedef std::chrono::steady_clock Clock;
+
+double milliseconds(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// median Dijkstra time over the same sources, given in original IDs
+double median_dijkstra_ms(const Graph& g, const VertexOrder* order, const std::vector<size_t>& sources, double& checksum) {
+    std::vector<double> latencies;
+    Graph::ShortestPaths result;
+    for (size_t src : sources) {
+        size_t id = order ? order->to_new(src) : src;
+        Clock::time_point start = Clock::now();
+        g.shortest_paths(id, result);
+        latencies.push_back(milliseconds(start));
+        checksum += result.distance(order ? order->to_new(sources[0]) : sources[0]);
+    }
+    std::sort(latencies.begin(), latencies.end());
+    return latencies[latencies.size() / 2];
+}
+
+int main(int argc, char** argv) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    size_t side = static_cast<size_t>(std::sqrt(static_cast<double>(n)));
+    n = side * side;
+
+    // road-like grid with 10% of its streets missing and weights proportional to length
+    std::mt19937_64 rng(42);
+    std::vector<size_t> shuffled(n);
+    for (size_t v = 0; v < n; v++) {
+        shuffled[v] = v;
+    }
+    std::shuffle(shuffled.begin(), shuffled.end(), rng);
+    std::uniform_real_distribution<double> length(80, 120);
+    std::bernoulli_distribution missing(0.1);
+    std::vector<Graph::Edge> edges;
+    edges.reserve(4 * n);
+    for (size_t r = 0; r < side; r++) {
+        for (size_t c = 0; c < side; c++) {
+            size_t v = shuffled[r * side + c];
+            if (c + 1 < side && !missing(rng)) {
+                double w = length(rng);
+                edges.push_back(Graph::Edge{v, shuffled[r * side + c + 1], w});
+                edges.push_back(Graph::Edge{shuffled[r * side + c + 1], v, w});
+            }
+            if (r + 1 < side && !missing(rng)) {
+                double w = length(rng);
+                edges.push_back(Graph::Edge{v, shuffled[(r + 1) * side + c], w});
+                edges.push_back(Graph::Edge{shuffled[(r + 1) * side + c], v, w});
+            }
+        }
+    }
+
+    Graph g = Graph::from_edges(edges, shuffled, Graph::dense_ids);
+    for (size_t r = 0; r < side; r++) {
+        for (size_t c = 0; c < side; c++) {
+            g.set_coordinates(shuffled[r * side + c], static_cast<double>(c), static_cast<double>(r));
+        }
+    }
+    edges.clear();
+    edges.shrink_to_fit();
+
+    std::uniform_int_distribution<size_t> vertex(0, n - 1);
+    std::vector<size_t> sources(n <= 100000 ? 50 : 10);
+    for (size_t& src : sources) {
+        src = vertex(rng);
+    }
+
+    std::cout << "order,vertices,edges,reorder_ms,dijkstra_p50_ms" << std::endl;
+    double checksum = 0;
+    std::cout << "shuffled," << g.vertex_count() << "," << g.edge_count() << ",0," << median_dijkstra_ms(g, nullptr, sources, checksum) << std::endl;
+
+    const char* names[] = {"reverse_cuthill_mckee", "hilbert"};
+    for (int method = 0; method < 2; method++) {
+        Clock::time_point start = Clock::now();
+        VertexOrder order = method == 0 ? cuthill_mckee_order(g) : hilbert_order(g);
+        Graph reordered = reorder(g, order);
+        double reorder_ms = milliseconds(start);
+        std::cout << names[method] << "," << reordered.vertex_count() << "," << reordered.edge_count() << "," << reorder_ms << ","
+                  << median_dijkstra_ms(reordered, &order, sources, checksum) << std::endl;
+    }
+    std::cerr << "checksum " << checksum << std::endl; // keeps the searches observable
+    return 0;
+}
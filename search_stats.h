@@ -0,0 +1,117 @@
+/*
+*   Opt-in instrumentation for the shortest path searches
+*   Compile with -DGRAPH_STATS and every search (Graph, CompactGraph, ContractionHierarchy, DeltaStepping) counts
+*   settled vertices, relaxed edges, queue pushes, stale pops and the peak queue size, and times its phases.
+*   The finished record is kept per thread (last_search_stats()) and handed to the sink installed with
+*   set_stats_sink(), if any. Without the flag SearchRecorder is an empty class whose calls inline to nothing.
+*/
+
+#pragma once
+#include <functional>
+#include <chrono>
+#include <algorithm> // max
+#include <cstring> // strcmp
+
+struct SearchStats {
+#ifdef GRAPH_STATS
+    static constexpr bool enabled = true;
+#else
+    static constexpr bool enabled = false;
+#endif
+    static constexpr size_t max_phases = 4;
+
+    struct Phase {
+        const char* name;
+        double ms;
+    };
+
+    const char* algorithm; // e.g. "dijkstra", "astar"
+    size_t source;         // source ID as passed to the search
+    size_t settled;
+    size_t relaxed;        // edges scanned from settled vertices
+    size_t pushes;
+    size_t stale_pops;     // lazy queue entries skipped because a better one was popped earlier
+    size_t peak_queue;
+    Phase phases[max_phases];
+    size_t phase_count;
+    double total_ms;
+
+    SearchStats()
+        : algorithm{""}, source{static_cast<size_t>(-1)}, settled{0}, relaxed{0}, pushes{0}, stale_pops{0},
+          peak_queue{0}, phases{}, phase_count{0}, total_ms{0} {}
+};
+
+typedef std::function<void(const SearchStats&)> StatsSink;
+
+// install before searching - the sink is called on whichever thread ran the search and must not throw
+inline StatsSink& stats_sink() {
+    static StatsSink sink;
+    return sink;
+}
+
+inline void set_stats_sink(StatsSink sink) { stats_sink() = std::move(sink); }
+
+// the last search finished on the calling thread, all zero without GRAPH_STATS
+inline SearchStats& last_search_stats() {
+    static thread_local SearchStats stats;
+    return stats;
+}
+
+#ifdef GRAPH_STATS
+// collects one search's counters and publishes them when it goes out of scope
+class SearchRecorder {
+    typedef std::chrono::steady_clock Clock;
+
+    SearchStats stats;
+    Clock::time_point started;
+    Clock::time_point phase_started;
+
+    public:
+    SearchRecorder(const char* algorithm, size_t source) : stats{}, started{Clock::now()}, phase_started{started} {
+        stats.algorithm = algorithm;
+        stats.source = source;
+    }
+
+    SearchRecorder(const SearchRecorder&) = delete;
+    SearchRecorder& operator=(const SearchRecorder&) = delete;
+
+    ~SearchRecorder() {
+        stats.total_ms = std::chrono::duration<double, std::milli>(Clock::now() - started).count();
+        last_search_stats() = stats;
+        if (stats_sink()) stats_sink()(stats);
+    }
+
+    void settle(size_t count = 1) { stats.settled += count; }
+    void relax(size_t count = 1) { stats.relaxed += count; }
+    void stale() { stats.stale_pops++; }
+
+    void push(size_t queue_size) {
+        stats.pushes++;
+        stats.peak_queue = std::max(stats.peak_queue, queue_size);
+    }
+
+    // ends the running phase under name and starts the next one - repeated names accumulate
+    void phase(const char* name) {
+        Clock::time_point now = Clock::now();
+        double ms = std::chrono::duration<double, std::milli>(now - phase_started).count();
+        phase_started = now;
+        for (size_t p = 0; p < stats.phase_count; p++) {
+            if (std::strcmp(stats.phases[p].name, name) == 0) {
+                stats.phases[p].ms += ms;
+                return;
+            }
+        }
+        if (stats.phase_count < SearchStats::max_phases) stats.phases[stats.phase_count++] = SearchStats::Phase{name, ms};
+    }
+};
+#else
+class SearchRecorder {
+    public:
+    SearchRecorder(const char*, size_t) {}
+    void settle(size_t = 1) {}
+    void relax(size_t = 1) {}
+    void stale() {}
+    void push(size_t) {}
+    void phase(const char*) {}
+};
+#endif
@@ -0,0 +1,41 @@
+/*
+*   Copy-on-write handle to a graph
+*   Copies of a SharedGraph, and the read-only snapshots it hands out, share one graph - taking one is O(1) whatever
+*   the graph's size. The first edit made while anything else still shares the graph copies it once, so the
+*   snapshots keep seeing the graph as it was when they were taken. Edits while nothing is shared cost nothing extra.
+*   One handle is not meant to be used from several threads at once; snapshots can be read anywhere.
+*   The reference edit() returns is only good until the next snapshot() or copy of the handle - edits made through
+*   a kept reference after that would show up in the snapshot. Call edit() again instead.
+*/
+
+#pragma once
+#include "graph.h"
+#include <memory> // shared_ptr
+#include <atomic> // atomic_thread_fence
+
+template <class G = Graph>
+class SharedGraph {
+    std::shared_ptr<G> body;
+
+    public:
+    SharedGraph() : body{std::make_shared<G>()} {}
+    explicit SharedGraph(G graph) : body{std::make_shared<G>(std::move(graph))} {}
+
+    // reads never copy
+    const G& operator*() const { return *body; }
+    const G* operator->() const { return body.get(); }
+
+    // the graph to change - copied first if a snapshot or another handle still shares it
+    G& edit() {
+        if (body.use_count() > 1) body = std::make_shared<G>(*body);
+        // use_count() is a relaxed load - pair it with the release of the last other owner dropping the graph, so
+        // that owner's reads on another thread happen before the writes made through the returned reference
+        else std::atomic_thread_fence(std::memory_order_acquire);
+        return *body;
+    }
+
+    // read-only view for a background job - stays valid and unchanged however this handle is edited afterwards
+    std::shared_ptr<const G> snapshot() const { return body; }
+
+    bool shared() const { return body.use_count() > 1; }
+};